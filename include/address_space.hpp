@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "node_id.hpp"
+
+enum class NodeClass : uint8_t {
+    Object = 1,
+    Variable = 2
+};
+
+// Ссылка, возвращаемая службой Browse сервера
+struct BrowseReference {
+    NodeId target;
+    std::string browseName;
+    NodeClass nodeClass;
+};
+
+// Узел локальной копии адресного пространства
+struct BrowseNode {
+    NodeId id;
+    std::string browseName;
+    NodeClass nodeClass;
+    uint32_t parent;        // npos у корня
+    uint32_t tag;           // индекс тега в хранилище, npos - не привязан
+};
+
+// Кэш адресного пространства сервера. Дерево обходится один раз в ширину,
+// причём весь уровень дерева уходит одним запросом Browse, поэтому
+// запросов столько, какова глубина дерева. Потом узлы
+// ищутся по NodeId хешем без разбора строк и без обращения к серверу.
+class AddressSpaceCache {
+public:
+    static constexpr uint32_t npos = static_cast<uint32_t>(-1);
+
+    // Один запрос Browse: для каждого узла из nodes - его прямые потомки
+    using BrowseService = std::function<bool(const std::vector<NodeId>& nodes,
+                                             std::vector<std::vector<BrowseReference>>& results)>;
+    // NodeId -> индекс тега (npos, если тега нет)
+    using TagResolver = std::function<uint32_t(const NodeId& id)>;
+
+private:
+    std::vector<BrowseNode> nodes;
+    std::vector<uint32_t> childStart;     // CSR: потомки узла i - children[childStart[i] .. childStart[i+1])
+    std::vector<uint32_t> children;
+    std::unordered_map<NodeId, uint32_t> index;
+    size_t requests = 0;
+    mutable std::shared_mutex cache_mutex;
+
+public:
+    // Корень по умолчанию - папка Objects (i=85)
+    static NodeId objectsFolder() { return NodeId::numeric(0, 85); }
+
+    // Обходит дерево от root и заменяет содержимое кэша. Возвращает число узлов.
+    size_t load(const BrowseService& browse, const TagResolver& resolveTag,
+                const NodeId& root = objectsFolder(), size_t maxDepth = 32);
+    void clear();
+
+    size_t size() const;
+    size_t requestCount() const;
+
+    bool find(const NodeId& id, BrowseNode& out) const;
+    uint32_t resolveTag(const NodeId& id) const;
+
+    // Потомки узла из кэша (без запроса к серверу)
+    std::vector<BrowseNode> browse(const NodeId& parent) const;
+    // Все переменные дерева
+    std::vector<BrowseNode> variables() const;
+};
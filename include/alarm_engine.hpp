@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include "tag_store.hpp"
+
+enum class AlarmType : uint8_t {
+    High = 0,           // значение выше предела
+    Low = 1,            // значение ниже предела
+    RateOfChange = 2    // |скорость изменения| выше предела, ед./с
+};
+
+const char* alarmTypeToString(AlarmType type);
+
+struct AlarmRule {
+    uint32_t tag;
+    AlarmType type;
+    double limit;
+    double deadband = 0.0;   // гистерезис для снятия тревоги
+    int delayMs = 0;         // условие должно держаться столько мс до срабатывания
+};
+
+// Переход состояния тревоги
+struct AlarmEvent {
+    uint32_t rule;
+    uint32_t tag;
+    AlarmType type;
+    bool active;             // true - тревога возникла, false - снята
+    double value;            // значение (для RateOfChange - скорость)
+    int64_t timestampMs;
+};
+
+// Событийный движок тревог. Обрабатывает только пришедшие отсчёты:
+// для каждого тега правила найдены через CSR-индекс, параметры правил и
+// состояние хранятся в непрерывных массивах, проверка пределов идёт
+// одним циклом без ветвлений по собранным в пачку данным.
+class AlarmEngine {
+private:
+    // Правила (SoA). Для Low знак инвертирован, чтобы все типы
+    // проверялись одним сравнением: sign * x > raiseLevel
+    std::vector<uint32_t> ruleTag;
+    std::vector<AlarmType> ruleType;
+    std::vector<double> ruleSign;
+    std::vector<double> raiseLevel;
+    std::vector<double> clearLevel;
+    std::vector<int32_t> ruleDelay;
+
+    // Состояние правил
+    std::vector<uint8_t> ruleActive;
+    std::vector<int64_t> pendingSince;   // начало выполнения условия (для задержки)
+
+    // Индекс тег -> правила (CSR)
+    std::vector<uint32_t> tagRuleStart;
+    std::vector<uint32_t> tagRules;
+    bool indexDirty = false;
+
+    // Предыдущий отсчёт тега для RateOfChange
+    std::vector<double> lastValue;
+    std::vector<int64_t> lastTime;
+
+    // Рабочие буферы пачки
+    std::vector<uint32_t> batchRule;
+    std::vector<double> batchX;
+    std::vector<double> batchRaise;
+    std::vector<double> batchClear;
+    std::vector<int64_t> batchTime;
+    std::vector<uint8_t> batchOver;
+    std::vector<uint8_t> batchUnder;
+
+    std::mutex engine_mutex;
+
+    std::deque<AlarmEvent> events;
+    size_t maxEvents = 10000;
+    uint64_t droppedEvents = 0;
+    std::mutex events_mutex;
+
+    void rebuildIndex();
+    void emit(const AlarmEvent& event);
+
+public:
+    size_t addRule(const AlarmRule& rule);
+    size_t ruleCount();
+
+    // Вызывается из пути сбора данных для каждой пачки отсчётов
+    void process(const TagSample* samples, size_t count);
+
+    // Забирает до maxCount событий из очереди, возвращает их число
+    size_t pollEvents(std::vector<AlarmEvent>& out, size_t maxCount = static_cast<size_t>(-1));
+
+    bool isActive(size_t rule);
+    size_t activeCount();
+    uint64_t droppedCount();
+    void setQueueLimit(size_t limit);
+};
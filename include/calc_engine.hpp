@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "tag_store.hpp"
+
+enum class CalcOp : uint8_t {
+    PushConst,      // arg - индекс константы
+    PushTag,        // arg - индекс тега в хранилище
+    PushCalc,       // arg - индекс формулы (вычисляемый тег)
+    Add, Sub, Mul, Div, Pow, Neg,
+    Abs, Sqrt, Min, Max
+};
+
+struct CalcInstr {
+    CalcOp op;
+    uint32_t arg;
+};
+
+// Вычисляемые теги. Выражение вида "Voltage * Current" компилируется
+// один раз в байткод стековой машины. Формула может ссылаться только на
+// уже существующие формулы, поэтому порядок добавления - топологический,
+// и граф зависимостей всегда ацикличен. При изменении входов
+// пересчитываются только зависимые формулы, в порядке добавления.
+class CalcEngine {
+public:
+    static constexpr uint32_t npos = static_cast<uint32_t>(-1);
+
+    // Имя тега -> индекс в хранилище (TagStore::npos, если тега нет)
+    using Resolver = std::function<size_t(std::string_view)>;
+
+private:
+    std::vector<CalcInstr> code;
+    std::vector<double> constants;
+
+    // Формулы (SoA)
+    std::vector<uint32_t> formulaTarget;
+    std::vector<uint32_t> codeBegin;
+    std::vector<uint32_t> codeEnd;
+    std::vector<double> formulaValue;
+    std::vector<TagQuality> formulaQuality;
+
+    // Тег -> формула, которая его вычисляет
+    std::vector<uint32_t> tagFormula;
+
+    // Тег -> формулы, читающие его (CSR, перестраивается при добавлении)
+    std::vector<uint32_t> inputTags;        // входы всех формул подряд
+    std::vector<uint32_t> inputBegin;       // начало входов формулы (размер = formulas + 1)
+    std::vector<uint32_t> dependentStart;
+    std::vector<uint32_t> dependents;
+    bool indexDirty = false;
+
+    // Рабочие буферы вычисления
+    std::vector<double> stack;
+    std::vector<uint8_t> queued;
+    std::vector<uint32_t> pending;          // очередь формул (min-heap по индексу)
+    size_t maxDepth = 0;
+
+    void rebuildIndex();
+    void markDependents(uint32_t tag);
+    double run(uint32_t formula, const TagStore& store, TagQuality& quality);
+
+public:
+    // Компилирует выражение для тега target. При ошибке возвращает false
+    // и описание в error; движок не меняется.
+    bool addFormula(uint32_t target, const std::string& expression,
+                    const Resolver& resolve, std::string& error);
+
+    bool isCalculated(uint32_t tag) const;
+    size_t formulaCount() const { return formulaTarget.size(); }
+
+    // Пересчитывает формулы, зависящие от изменившихся тегов.
+    // Результаты добавляются в out в топологическом порядке.
+    void evaluate(const TagStore& store, const TagSample* changed, size_t count,
+                  std::vector<TagSample>& out);
+
+    // Полный пересчёт всех формул (после загрузки конфигурации)
+    void evaluateAll(const TagStore& store, int64_t timestampMs, std::vector<TagSample>& out);
+};
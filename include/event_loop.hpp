@@ -0,0 +1,141 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// Внутренний цикл событий клиента: очередь задач и таймеры в одном потоке.
+// Асинхронные операции не блокируют потоки ожиданием - задержки и
+// таймауты оформлены таймерами.
+class EventLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Task = std::function<void()>;
+
+private:
+    struct Timer {
+        Clock::time_point due;
+        uint64_t id;
+        Task task;
+    };
+    struct TimerLater {
+        bool operator()(const Timer& a, const Timer& b) const { return a.due > b.due; }
+    };
+
+    std::thread worker;
+    std::mutex loop_mutex;
+    std::condition_variable wakeup;
+    std::deque<Task> tasks;
+    std::priority_queue<Timer, std::vector<Timer>, TimerLater> timers;
+    std::unordered_set<uint64_t> activeTimers;
+    std::unordered_set<uint64_t> cancelledTimers;
+    uint64_t nextTimerId = 1;
+    bool stopping = false;
+
+    void run();
+
+public:
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    void post(Task task);
+    uint64_t schedule(std::chrono::milliseconds delay, Task task);
+    void cancelTimer(uint64_t id);
+    void stop();
+
+    bool isLoopThread() const { return std::this_thread::get_id() == worker.get_id(); }
+};
+
+enum class AsyncStatus : uint8_t {
+    Pending,
+    Completed,
+    Failed,
+    TimedOut,
+    Cancelled
+};
+
+const char* asyncStatusToString(AsyncStatus status);
+
+template <typename T>
+struct AsyncResult {
+    AsyncStatus status = AsyncStatus::Pending;
+    T value{};
+    std::string error;
+
+    bool ok() const { return status == AsyncStatus::Completed; }
+};
+
+// Дескриптор выполняющейся операции
+class AsyncOperation {
+protected:
+    std::atomic<AsyncStatus> state{AsyncStatus::Pending};
+
+public:
+    virtual ~AsyncOperation() = default;
+
+    // true, если операция ещё выполнялась и была отменена
+    virtual bool cancel() = 0;
+
+    AsyncStatus status() const { return state.load(); }
+    bool done() const { return status() != AsyncStatus::Pending; }
+};
+
+using AsyncHandle = std::shared_ptr<AsyncOperation>;
+
+// Операция с результатом типа T. Завершается ровно один раз: первым из
+// результата, таймаута или отмены. Обратный вызов выполняется в потоке
+// цикла событий.
+template <typename T>
+class AsyncCall : public AsyncOperation {
+public:
+    using Callback = std::function<void(const AsyncResult<T>&)>;
+
+private:
+    EventLoop& loop;
+    Callback callback;
+    std::atomic<uint64_t> timeoutTimer{0};
+
+public:
+    AsyncCall(EventLoop& l, Callback cb) : loop(l), callback(std::move(cb)) {}
+
+    void setTimeoutTimer(uint64_t id) {
+        timeoutTimer = id;
+        // Операция могла завершиться раньше, чем таймер был запомнен
+        if (done()) loop.cancelTimer(id);
+    }
+
+    bool complete(AsyncStatus status, T value = T(), std::string error = std::string()) {
+        AsyncStatus expected = AsyncStatus::Pending;
+        if (!state.compare_exchange_strong(expected, status)) {
+            return false;
+        }
+
+        uint64_t timer = timeoutTimer.exchange(0);
+        if (timer != 0) loop.cancelTimer(timer);
+
+        if (callback) {
+            AsyncResult<T> result;
+            result.status = status;
+            result.value = std::move(value);
+            result.error = std::move(error);
+            loop.post([cb = callback, result]() { cb(result); });
+        }
+        return true;
+    }
+
+    bool cancel() override {
+        return complete(AsyncStatus::Cancelled, T(), "cancelled");
+    }
+};
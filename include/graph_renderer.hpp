@@ -7,12 +7,14 @@ class GraphRenderer {
 private:
     HWND hWnd;
     std::vector<double> data;
+    std::vector<double> rawData;    // исходный ряд до фильтров (если есть)
     std::string title;
     std::string unit;
     
     COLORREF bgColor = RGB(30, 30, 40);
     COLORREF gridColor = RGB(60, 60, 70);
     COLORREF lineColor = RGB(0, 200, 255);
+    COLORREF rawLineColor = RGB(120, 120, 140);
     COLORREF pointColor = RGB(255, 100, 100);
     COLORREF textColor = RGB(220, 220, 220);
     
@@ -21,6 +23,7 @@ private:
 public:
     GraphRenderer(HWND hwnd, const std::string& title, const std::string& unit);
     void setData(const std::vector<double>& newData);
+    void setRawData(const std::vector<double>& newRawData);   // пустой - не рисовать
     void render(HDC hdc, RECT clientRect);
     void clear();
 };
\ No newline at end of file
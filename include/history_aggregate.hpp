@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class OPCUAClient;
+
+// Агрегаты по интервалам (по образцу processed aggregates HistoryRead)
+enum AggregateFlags : uint32_t {
+    AGGREGATE_AVERAGE = 1 << 0,
+    AGGREGATE_MINIMUM = 1 << 1,
+    AGGREGATE_MAXIMUM = 1 << 2,
+    AGGREGATE_COUNT = 1 << 3,
+    AGGREGATE_TIME_AVERAGE = 1 << 4,    // среднее, взвешенное по времени (ступенчатое)
+    AGGREGATE_ALL = 0x1F
+};
+
+// Результат по одному тегу: интервал k начинается в startMs + k * intervalMs.
+// Массивы заполнены только для запрошенных агрегатов; NaN - в интервале нет данных.
+struct AggregateSeries {
+    std::string tag;
+    bool found = false;
+    int64_t startMs = 0;
+    int64_t intervalMs = 0;
+    size_t intervals = 0;
+
+    std::vector<double> average;
+    std::vector<double> minimum;
+    std::vector<double> maximum;
+    std::vector<uint32_t> count;
+    std::vector<double> timeAverage;
+};
+
+// Агрегатные запросы к истории тегов.
+// История каждого тега читается кусками (как в HistoryExporter); внутри куска
+// отсчёты одного интервала идут подряд, и сумма, минимум и максимум считаются
+// развёрнутыми циклами по непрерывному участку. Теги обрабатываются
+// параллельно несколькими потоками.
+//
+// Время [startMs, endMs) делится на интервалы по intervalMs. Для среднего по
+// времени значение держится до следующего отсчёта, последнее - до endMs.
+class HistoryAggregator {
+private:
+    OPCUAClient& client;
+    size_t chunkSize;
+    size_t threads;
+
+    struct Scratch {
+        std::vector<double> values;
+        std::vector<int64_t> timestamps;
+        std::vector<double> sum;
+        std::vector<double> weighted;
+        std::vector<int64_t> covered;
+    };
+
+    void aggregateTag(AggregateSeries& series, int64_t endMs, uint32_t flags, Scratch& scratch);
+
+public:
+    // threads = 0 - по числу ядер
+    explicit HistoryAggregator(OPCUAClient& client, size_t chunkSize = 4096, size_t threads = 0);
+
+    bool query(const std::vector<std::string>& tagNames, int64_t startMs, int64_t endMs,
+               int64_t intervalMs, uint32_t flags, std::vector<AggregateSeries>& out);
+};
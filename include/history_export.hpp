@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class OPCUAClient;
+
+// Потоковый экспорт истории тегов.
+// История читается кусками по chunkSize отсчётов (history_mutex держится
+// только на время копирования куска), текст форматируется std::to_chars
+// в переиспользуемый буфер, в файл уходят крупные последовательные записи.
+// Расход памяти не зависит от объёма экспорта.
+//
+// CSV:      tag,timestamp_ms,value
+// Колонки:  "OPCHIST1" | uint32 версия, далее блоки
+//           uint16 длина имени | имя | uint32 n | int64 ts[n] | double value[n]
+class HistoryExporter {
+private:
+    OPCUAClient& client;
+    size_t chunkSize;
+
+    std::vector<double> chunkValues;
+    std::vector<int64_t> chunkTimestamps;
+    std::vector<char> out;
+    size_t outUsed = 0;
+    std::ofstream file;
+    uint64_t exported = 0;
+
+    bool openFile(const std::string& path);
+    bool finishFile(const std::string& path);
+    void put(const char* data, size_t size);
+    void flushOut();
+
+public:
+    explicit HistoryExporter(OPCUAClient& client, size_t chunkSize = 4096, size_t writeBufferSize = 1 << 20);
+
+    // Экспортирует то, что было в истории на момент начала экспорта тега.
+    // Отсчёты, вытесненные из буфера во время экспорта, пропускаются.
+    bool exportCsv(const std::string& path, const std::vector<std::string>& tagNames);
+    bool exportColumnar(const std::string& path, const std::vector<std::string>& tagNames);
+
+    uint64_t exportedCount() const { return exported; }
+};
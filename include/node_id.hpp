@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+enum class NodeIdType : uint8_t {
+    Numeric = 0,    // i=
+    String = 1,     // s=
+    Guid = 2        // g=
+};
+
+struct NodeGuid {
+    uint32_t data1 = 0;
+    uint16_t data2 = 0;
+    uint16_t data3 = 0;
+    uint8_t data4[8] = {};
+};
+
+// Разобранный NodeId: пространство имён и идентификатор (число, строка или GUID).
+// Разбирается один раз; сравнение и хеш не трогают текстовую форму,
+// для числовых идентификаторов - это пара целых.
+class NodeId {
+private:
+    uint16_t ns = 0;
+    NodeIdType idType = NodeIdType::Numeric;
+    uint32_t numericId = 0;
+    NodeGuid guidId;
+    std::string stringId;
+
+public:
+    NodeId() = default;
+
+    static NodeId numeric(uint16_t ns, uint32_t id);
+    static NodeId string(uint16_t ns, std::string_view id);
+    static NodeId guid(uint16_t ns, const NodeGuid& id);
+
+    // Текстовая форма OPC UA: "ns=2;i=2", "i=85", "ns=1;s=Pump.Speed",
+    // "ns=1;g=09087e75-8e5e-499b-954f-f2a9603db28a". ns=0 можно опускать.
+    static bool parse(std::string_view text, NodeId& out);
+
+    // Как parse, но нестандартная строка из конфигурации не теряется:
+    // она становится строковым идентификатором в пространстве 0
+    static NodeId fromText(std::string_view text);
+
+    uint16_t namespaceIndex() const { return ns; }
+    NodeIdType type() const { return idType; }
+    uint32_t numericValue() const { return numericId; }
+    const std::string& stringValue() const { return stringId; }
+    const NodeGuid& guidValue() const { return guidId; }
+    bool isNull() const { return ns == 0 && idType == NodeIdType::Numeric && numericId == 0; }
+
+    std::string toString() const;
+    size_t hash() const;
+
+    bool operator==(const NodeId& other) const;
+    bool operator!=(const NodeId& other) const { return !(*this == other); }
+    bool operator<(const NodeId& other) const;
+};
+
+namespace std {
+template <>
+struct hash<NodeId> {
+    size_t operator()(const NodeId& id) const { return id.hash(); }
+};
+}  // namespace std
@@ -7,74 +7,274 @@
 #include <thread>
 #include <iomanip>
 #include <ctime>
+#include <cstddef>
 #include <mutex>
-#include <map>
+#include <deque>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+#include "tag_config.hpp"
+#include "tag_store.hpp"
+#include "sample_trace.hpp"
+#include "alarm_engine.hpp"
+#include "calc_engine.hpp"
+#include "event_loop.hpp"
+#include "store_forward.hpp"
+#include "node_id.hpp"
+#include "address_space.hpp"
+#include "shm_feed.hpp"
+#include "signal_filter.hpp"
 
 class OPCUAClient {
 public:
     // Вложенные структуры должны быть публичными или нужно добавить геттеры
+    // Снимок одного тега. Строки ссылаются на интернированную таблицу
+    // хранилища (нуль-терминированы, живут столько же, сколько клиент),
+    // поэтому копирование снимка не трогает кучу.
     struct TagData {
-        std::string name;
-        std::string nodeId;
+        std::string_view name;
+        std::string_view nodeId;
         double value;
-        std::string unit;
-        std::string timestamp;
-        std::string quality;
+        std::string_view unit;
+        int64_t timestampMs;
+        TagQuality quality;
         bool is_written;
         
-        TagData(const std::string& n, const std::string& id, const std::string& u)
-            : name(n), nodeId(id), value(0.0), unit(u), quality("GOOD"), is_written(false) {}
-        
-        void update(double newValue, bool written = false);
-        void updateTimestamp();
+        std::string timestamp() const;     // "ЧЧ:ММ:СС" по локальному времени
+        const char* qualityString() const { return qualityToString(quality); }
         void print() const;
     };
     
+    // История тега - кольцевой буфер. Каждый отсчёт имеет сквозной номер,
+    // по нему читатели (экспорт, графики) продолжают чтение кусками,
+    // даже если буфер тем временем сдвинулся.
     struct TagHistory {
         std::vector<double> values;
-        std::vector<std::string> timestamps;
+        std::vector<int64_t> timestamps;
         size_t maxHistory = 50;
+        size_t head = 0;        // позиция самого старого отсчёта
+        size_t count = 0;
+        uint64_t total = 0;     // всего добавлено = номер следующего отсчёта
         
-        void addValue(double value, const std::string& timestamp);
+        void addValue(double value, int64_t timestampMs);
         void clear();
+        void setCapacity(size_t capacity);
+        
+        size_t size() const { return count; }
+        uint64_t firstSeq() const { return total - count; }
+        
+        // Копирует до maxCount отсчётов начиная с номера seq (не раньше firstSeq)
+        size_t read(uint64_t seq, size_t maxCount, double* outValues, int64_t* outTimestamps) const;
+        void copyValues(std::vector<double>& out) const;   // в хронологическом порядке
     };
     
 private:
-    std::vector<TagData> tags;
-    mutable std::mutex tags_mutex;
+    TagStore store;                              // живые значения, без глобальной блокировки
+    std::mutex acquisition_mutex;                // генератор и буфер цикла опроса
+    mutable std::mutex pipeline_mutex;           // формулы, трасса, буфер досылки
     std::string endpoint;
-    bool connected;
+    std::atomic<bool> connected;
     std::random_device rd;
     std::mt19937 gen;
-    std::map<std::string, double> written_values;
     
-    std::map<std::string, TagHistory> tagHistories;  // ← ОСТАВИТЬ ЭТУ СТРОКУ
+    std::vector<TagSample> cycleSamples;         // буфер отсчётов цикла опроса
+    std::unique_ptr<SampleRecorder> recorder;    // запись потока отсчётов (если включена)
+    AlarmEngine alarmEngine;
+    CalcEngine calcEngine;
+    std::vector<TagSample> derivedSamples;       // результаты вычисляемых тегов за цикл
+    
+    // Обработка сигнала между сбором и хранилищем
+    SignalConditioner conditioner;
+    std::atomic<bool> conditioningEnabled{false};
+    std::mutex conditioning_mutex;               // буфер обработанной пачки
+    std::vector<TagSample> conditionedSamples;
+    
+    // Сохранить и переслать: записи и отсчёты на время обрыва связи.
+    // enableStoreAndForward заменяет состояние целиком под pipeline_mutex,
+    // такт досылки в потоке цикла событий работает со своей копией указателя.
+    struct ForwardState {
+        StoreForwardBuffer buffer;
+        std::vector<std::byte> arena;            // память под временные пачки досылки
+        size_t batch;
+        size_t rate;                             // записей в секунду при досылке
+        
+        ForwardState(size_t ringCapacity, const std::string& spillPath, size_t drainBatch, size_t drainRate);
+    };
+    std::shared_ptr<ForwardState> forward;
+    std::vector<ForwardRecord> forwardScratch;
+    std::function<void(const ForwardRecord*, size_t)> forwardSink;
+    std::atomic<bool> drainScheduled{false};
+    
+    AddressSpaceCache addressCache;              // дерево узлов сервера после browse
+    
+    // Зеркало живых значений для других процессов; читается через atomic_load
+    std::shared_ptr<SharedMemoryPublisher> shmFeed;
+    
+    // Исходный (до фильтров) ряд тега с фильтрами. Пополняется вместе
+    // с tagHistories: при каждой публикации туда уходит предыдущий
+    // исходный отсчёт, так что оба ряда совпадают отсчёт в отсчёт.
+    struct RawSeries {
+        TagHistory history;
+        double lastValue = 0.0;
+        int64_t lastTimestampMs = 0;
+        bool enabled = false;
+    };
+    
+    std::deque<TagHistory> tagHistories;  // по индексу тега ← ОСТАВИТЬ ЭТУ СТРОКУ
+    std::deque<RawSeries> rawSeries;      // по индексу тега; буфер только у enabled
     std::mutex history_mutex;  // ← ОСТАВИТЬ ЭТУ СТРОКУ
+    size_t historyCapacity = 50;
     
 public:
     OPCUAClient();
     
+    // Синхронное подключение (ожидает connectAsync). Не вызывать из обратных вызовов.
     bool connect(const std::string& url);
     void disconnect();
     bool isConnected() const;
     
+    // Асинхронный API: операции выполняет внутренний цикл событий,
+    // обратный вызов приходит в его потоке. timeout = 0 - без таймаута.
+    // Возвращаемый дескриптор позволяет отменить операцию.
+    AsyncHandle connectAsync(const std::string& url, std::chrono::milliseconds timeout,
+                             AsyncCall<bool>::Callback callback);
+    AsyncHandle readAsync(const std::string& tagName, std::chrono::milliseconds timeout,
+                          AsyncCall<TagData>::Callback callback);
+    AsyncHandle writeAsync(const std::string& tagName, double value, std::chrono::milliseconds timeout,
+                           AsyncCall<bool>::Callback callback);
+    // Обходит адресное пространство сервера, заполняет addressSpace()
+    // и возвращает имена найденных переменных
+    AsyncHandle browseAsync(std::chrono::milliseconds timeout,
+                            AsyncCall<std::vector<std::string>>::Callback callback);
+    const AddressSpaceCache& addressSpace() const { return addressCache; }
+    
+    // NodeId -> индекс тега: через кэш browse, иначе по индексу хранилища
+    size_t resolveNode(const NodeId& nodeId) const;
+    
+    // Пока сессии нет, записи оператора и собранные отсчёты копятся в кольце
+    // на ringCapacity записей, излишек уходит в файл spillPath. После
+    // подключения буфер досылается пачками по drainBatch, не быстрее
+    // drainRatePerSec записей в секунду.
+    void enableStoreAndForward(size_t ringCapacity, const std::string& spillPath,
+                               size_t drainBatch = 500, size_t drainRatePerSec = 5000);
+    // Получатель досылаемых отсчётов (историк и т.п.), вызывается в потоке цикла событий.
+    // Записи оператора досылаются на сервер и сюда не попадают.
+    void setForwardSink(std::function<void(const ForwardRecord*, size_t)> sink);
+    uint64_t pendingForwardCount() const;
+    
+    // Живые значения в именованной разделяемой памяти (см. shm_feed.hpp) для
+    // локальных процессов. capacity = 0 - вдвое больше текущего числа тегов.
+    // Запущенная лента сначала останавливается; имя, занятое другим
+    // издателем, не переиспользуется.
+    bool startSharedMemoryFeed(const std::string& name, uint32_t capacity = 0);
+    void stopSharedMemoryFeed();
+    
     void addTag(const std::string& name, const std::string& nodeId, 
                 const std::string& unit, double minVal, double maxVal);
     
+    // Массовая регистрация: один reserve, формулы компилируются одним проходом
+    size_t addTags(const std::vector<TagConfig>& configs);
+    
+    // Вычисляемый тег: выражение над другими тегами, например "Voltage * Current".
+    // Поддерживаются + - * / ^, скобки, abs, sqrt, min, max, pow и [имена с пробелами].
+    bool addCalculatedTag(const std::string& name, const std::string& nodeId,
+                          const std::string& unit, const std::string& expression);
+    size_t loadTagsFromFile(const std::string& path);
+    
+    // Цикл опроса: тег обновляется, если прошёл его samplingMs
+    // (0 - в каждом цикле); записанные и вычисляемые теги пропускаются
     void updateValues();
+    
+    // Фильтр в конец цепочки тега (EMA, скользящее среднее, медиана,
+    // скорость изменения, отбрасывание выбросов). Хранилище, история и
+    // тревоги получают обработанное значение, исходный ряд - getRawHistoryValues.
+    bool addFilter(const std::string& tagName, const FilterConfig& config);
+    
+    // Общий путь сбора данных: хранилище, история, запись трассы.
+    // Сюда же подаёт отсчёты TraceReplayer; TAG_FLAG_WRITTEN в flags -
+    // пачка записей оператора. Возвращает число отсчётов, попавших в
+    // хранилище (отсчёт тега, записанного вручную, отбрасывается).
+    size_t applySamples(const TagSample* samples, size_t count, uint8_t flags = TAG_FLAG_NONE);
+    
+    // Детерминированная симуляция (одинаковая последовательность значений)
+    void setSimulationSeed(uint32_t seed);
+    
+    bool startRecording(const std::string& path);
+    void stopRecording();
+    
+    // Тревоги по пределам; переходы состояния читаются через alarms().pollEvents()
+    size_t addAlarm(const std::string& tagName, AlarmType type, double limit,
+                    double deadband = 0.0, int delayMs = 0);
+    AlarmEngine& alarms() { return alarmEngine; }
     std::vector<TagData> readAllTags();
     
     std::vector<TagData> getTags() const;
     
+    // Варианты для опроса без выделения памяти: заполняют буфер вызывающего,
+    // после первого цикла его ёмкости хватает. Возвращают число тегов.
+    size_t readAllTags(std::vector<TagData>& out);
+    size_t getTags(std::vector<TagData>& out) const;
+    
+    // Снимок живых значений в буферы вызывающего (копирование массивов)
+    void snapshotValues(std::vector<double>& values, std::vector<int64_t>& timestamps,
+                        std::vector<TagQuality>& qualities, std::vector<uint8_t>& flags) const;
+    
     bool writeTagByName(const std::string& tagName, double value);
     bool writeTagById(const std::string& nodeId, double value);
+    bool writeTagById(const NodeId& nodeId, double value);
     
     size_t tagCount() const;
-    TagData* getTagByName(const std::string& tagName);
+    size_t findTagIndex(const std::string& tagName) const;   // TagStore::npos, если нет
+    std::optional<TagData> getTagByName(const std::string& tagName) const;
     bool resetTagToAuto(const std::string& tagName);
     
     TagHistory* getTagHistory(const std::string& tagName);  // ← ОСТАВИТЬ ЭТУ СТРОКУ
-    void addToHistory(const std::string& tagName, double value, const std::string& timestamp);  // ← ОСТАВИТЬ ЭТУ СТРОКУ
+    void addToHistory(const std::string& tagName, double value, int64_t timestampMs);  // ← ОСТАВИТЬ ЭТУ СТРОКУ
+    
+    // Глубина истории на тег (по умолчанию 50 отсчётов)
+    void setHistoryCapacity(size_t capacity);
+    
+    // Потокобезопасные копии истории (getTagHistory отдаёт указатель без блокировки)
+    bool getHistoryValues(const std::string& tagName, std::vector<double>& out);
+    // История исходных (до фильтров) значений; false, если у тега нет фильтров
+    bool getRawHistoryValues(const std::string& tagName, std::vector<double>& out);
+    
+    // Чтение истории кусками: history_mutex держится только на время одного куска.
+    // seq - номер первого нужного отсчёта, на выходе - номер следующего.
+    // Отсчёты, вытесненные из буфера, пропускаются. endSeq ограничивает чтение сверху.
+    size_t readHistory(const std::string& tagName, uint64_t& seq, uint64_t endSeq,
+                       size_t maxCount, double* outValues, int64_t* outTimestamps);
+    
+    // Границы истории тега: [firstSeq, endSeq)
+    bool getHistoryRange(const std::string& tagName, uint64_t& firstSeq, uint64_t& endSeq);
+
+private:
+    // Имитация задержки установки сессии с сервером
+    static constexpr std::chrono::milliseconds connectLatency{500};
+    
+    // Цикл событий объявлен последним: при разрушении клиента он
+    // останавливается первым, пока остальные поля ещё живы
+    EventLoop loop;
+    
+    template <typename T>
+    std::shared_ptr<AsyncCall<T>> startCall(std::chrono::milliseconds timeout,
+                                            typename AsyncCall<T>::Callback callback);
+    
+    TagData makeTagData(size_t index) const;
+    bool browseServer(const std::vector<NodeId>& nodes,
+                      std::vector<std::vector<BrowseReference>>& results) const;
+    void scheduleDrain();
+    void drainForwardBuffer();
+    void writeToServer(size_t index, double value);
+    size_t publishSamples(const TagSample* samples, size_t count, uint8_t flags);
+    void processSamplesLocked(const TagSample* samples, const TagSample* rawSamples,
+                              size_t count, uint8_t flags);
+    TagHistory* findHistoryLocked(const std::string& tagName);
+    TagHistory& historyLocked(size_t index);
+    // rawSamples[k] - исходный отсчёт для samples[k] (для истории исходного ряда)
+    size_t storeSamples(const TagSample* samples, const TagSample* rawSamples, size_t count, uint8_t flags);
+    size_t compileFormulasLocked(const std::vector<std::pair<uint32_t, std::string>>& formulas);
 
     // ★★★ УДАЛИТЬ ВСЕ СТРОКИ НИЖЕ ЭТОЙ КОММЕНТАРИЯ ★★★
     // private:
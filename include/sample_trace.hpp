@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "tag_store.hpp"
+
+class OPCUAClient;
+
+// Формат трассы (порядок байт - нативный):
+//   "OPCTRACE" | uint32 версия | uint32 число тегов
+//   для каждого тега: uint16 длина имени | имя
+//   далее записи TraceRecord по 24 байта
+// Версия 1 хранила качество в uint32 и не различала записи оператора.
+struct TraceRecord {
+    int64_t timestampMs;
+    double value;
+    uint32_t tag;       // индекс в каталоге тегов трассы
+    uint8_t quality;
+    uint8_t flags;      // TAG_FLAG_WRITTEN - запись оператора, TRACE_FLAG_RESET - сброс в AUTO
+    uint16_t reserved;
+};
+
+// Сброс тега в AUTO (resetTagToAuto); value и quality не используются.
+// Бит вне TagFlags, чтобы не пересекаться с флагами тега.
+const uint8_t TRACE_FLAG_RESET = 1 << 7;
+
+// Запись потока отсчётов в компактную бинарную трассу
+class SampleRecorder {
+private:
+    std::ofstream file;
+    std::vector<TraceRecord> buffer;
+    uint32_t tagCount = 0;
+    uint64_t recorded = 0;
+
+    void flush();
+
+public:
+    ~SampleRecorder();
+
+    // Каталог тегов фиксируется при открытии; отсчёты тегов,
+    // добавленных позже, в трассу не попадают
+    bool open(const std::string& path, const std::vector<std::string>& tagNames);
+    // flags - TAG_FLAG_WRITTEN для записей оператора, иначе TAG_FLAG_NONE
+    void write(const TagSample* samples, size_t count, uint8_t flags);
+    void writeReset(uint32_t tag, int64_t timestampMs);
+    void close();
+
+    bool isOpen() const { return file.is_open(); }
+    uint64_t recordedCount() const { return recorded; }
+};
+
+// Воспроизведение трассы через обычный путь сбора данных клиента
+class TraceReplayer {
+private:
+    std::ifstream file;
+    std::vector<std::string> tagNames;
+    std::string path;
+    std::streamoff dataStart = 0;
+    uint32_t version = 0;
+
+public:
+    bool open(const std::string& path);
+    const std::vector<std::string>& tags() const { return tagNames; }
+
+    // speed = 1.0 - реальное время, N - ускорение в N раз,
+    // 0 - максимальная скорость без пауз. Записи оператора
+    // воспроизводятся как записи (в обход фильтров, с флагом WRITTEN).
+    // Возвращает число отсчётов, принятых хранилищем клиента.
+    uint64_t replay(OPCUAClient& client, double speed = 1.0);
+};
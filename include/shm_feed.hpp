@@ -0,0 +1,139 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "tag_store.hpp"
+
+// Раскладка области разделяемой памяти с живыми значениями.
+// Читают её другие процессы на этой машине, поэтому все структуры
+// фиксированного размера и без указателей:
+//
+//   ShmFeedHeader | ShmTagEntry[capacity] | ShmTagSlot[capacity]
+//
+// Слот защищён seqlock'ом: нечётный seq - идёт запись; читатель копирует
+// поля и повторяет чтение, если seq изменился. Ни блокировок, ни системных
+// вызовов на чтение.
+namespace shm_feed {
+
+const char kMagic[8] = {'O', 'P', 'C', 'L', 'I', 'V', 'E', '1'};
+const uint32_t kVersion = 1;
+const size_t kNameSize = 64;
+const size_t kNodeIdSize = 64;
+const size_t kUnitSize = 16;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t capacity;                      // мест под теги
+    uint32_t directoryOffset;               // смещения от начала области
+    uint32_t slotOffset;
+    std::atomic<uint32_t> tagCount;         // опубликовано записей каталога
+    std::atomic<uint32_t> publisherAlive;   // 0 - издатель закрыл ленту
+    std::atomic<uint64_t> updates;          // всего обновлений слотов
+};
+
+// Запись каталога: неизменна после публикации (tagCount увеличивается после записи)
+struct TagEntry {
+    char name[kNameSize];                   // нуль-терминированы, длинные обрезаются
+    char nodeId[kNodeIdSize];
+    char unit[kUnitSize];
+    double minValue;
+    double maxValue;
+};
+
+struct alignas(64) TagSlot {
+    std::atomic<uint32_t> seq;
+    std::atomic<uint8_t> quality;           // TagQuality
+    std::atomic<uint8_t> flags;             // TagFlags
+    std::atomic<double> value;
+    std::atomic<int64_t> timestampMs;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+              std::atomic<uint64_t>::is_always_lock_free &&
+              std::atomic<double>::is_always_lock_free,
+              "shared memory feed needs address-free lock-free atomics");
+
+size_t regionSize(uint32_t capacity);
+
+}  // namespace shm_feed
+
+// Именованная область разделяемой памяти: CreateFileMapping на Windows,
+// shm_open + mmap на POSIX
+class SharedRegion {
+private:
+    void* base = nullptr;
+    size_t length = 0;
+    std::string regionName;
+    bool owner = false;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#endif
+
+public:
+    SharedRegion() = default;
+    ~SharedRegion();
+
+    SharedRegion(const SharedRegion&) = delete;
+    SharedRegion& operator=(const SharedRegion&) = delete;
+
+    // Создаёт новую область; занятое имя - ошибка (чужую ленту не затираем)
+    bool create(const std::string& name, size_t size);
+    bool open(const std::string& name);     // размер берётся из самой области
+    void close();
+
+    void* data() const { return base; }
+    size_t size() const { return length; }
+};
+
+// Издатель: зеркалирует хранилище тегов в разделяемую память
+class SharedMemoryPublisher {
+private:
+    SharedRegion region;
+    shm_feed::Header* header = nullptr;
+    shm_feed::TagEntry* directory = nullptr;
+    shm_feed::TagSlot* slots = nullptr;
+    std::mutex directory_mutex;
+
+    void syncDirectory(const TagStore& store);
+
+public:
+    ~SharedMemoryPublisher();
+
+    bool open(const std::string& name, uint32_t capacity);
+    void close();
+    bool isOpen() const { return header != nullptr; }
+
+    // Копирует текущее состояние тега из хранилища в слот
+    void publish(const TagStore& store, size_t index);
+    void publishAll(const TagStore& store);
+};
+
+// Читатель для процессов-потребителей
+class SharedMemoryReader {
+public:
+    // Запись слота занимает доли микросекунды; столько попыток с yield
+    // хватает с большим запасом, дальше считаем издателя зависшим
+    static constexpr uint32_t kMaxReadAttempts = 100000;
+
+private:
+    SharedRegion region;
+    const shm_feed::Header* header = nullptr;
+    const shm_feed::TagEntry* directory = nullptr;
+    const shm_feed::TagSlot* slots = nullptr;
+
+public:
+    bool open(const std::string& name);
+    void close();
+
+    size_t tagCount() const;
+    size_t find(const std::string& name) const;   // TagStore::npos, если нет
+    const shm_feed::TagEntry& entry(size_t index) const { return directory[index]; }
+    bool publisherAlive() const;
+
+    // Согласованное чтение слота. false - индекс вне каталога, слот так
+    // и не освободился за kMaxReadAttempts попыток или издатель закрыл
+    // ленту посреди записи
+    bool read(size_t index, TagValue& out) const;
+};
@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "tag_store.hpp"
+
+enum class FilterType : uint8_t {
+    Ema = 0,            // экспоненциальное сглаживание
+    MovingAverage = 1,  // скользящее среднее по окну
+    Median = 2,         // скользящая медиана по окну
+    RateOfChange = 3,   // скорость изменения, ед./с
+    SpikeReject = 4     // отбрасывание выбросов
+};
+
+const char* filterTypeToString(FilterType type);
+
+struct FilterConfig {
+    FilterType type = FilterType::Ema;
+    double alpha = 0.2;         // Ema: вес нового отсчёта (0..1]
+    uint32_t window = 5;        // MovingAverage, Median: длина окна
+    double maxStep = 0.0;       // SpikeReject: допустимый скачок между отсчётами
+    uint32_t maxRejects = 3;    // SpikeReject: после стольких подряд скачок принимается
+};
+
+// Обработка сигнала между сбором и хранилищем.
+// У тега цепочка фильтров в порядке добавления. Пачка отсчётов проходит
+// цепочки по ступеням: на каждой ступени фильтры одного типа собраны
+// в свой список и считаются одним циклом по массивам состояния (SoA),
+// как проверки пределов в AlarmEngine. Стоимость отсчёта не зависит от
+// истории: скользящее среднее держит текущую сумму, медиана -
+// отсортированное окно ограниченной длины.
+class SignalConditioner {
+public:
+    static constexpr uint32_t kMaxWindow = 64;
+
+private:
+    static constexpr size_t kTypeCount = 5;
+
+    struct WorkItem {
+        uint32_t filter;    // индекс в массивах своего типа
+        uint32_t sample;    // индекс отсчёта в пачке
+    };
+
+    // Цепочки: тег -> фильтры (CSR, в порядке добавления)
+    std::vector<uint32_t> filterTag;
+    std::vector<FilterType> filterType;
+    std::vector<uint32_t> filterSlot;       // индекс в массивах своего типа
+    std::vector<uint32_t> tagFilterStart;
+    std::vector<uint32_t> tagFilters;
+    size_t maxChain = 0;
+    bool indexDirty = false;
+
+    // Ema
+    std::vector<double> emaAlpha;
+    std::vector<double> emaValue;
+    std::vector<uint8_t> emaPrimed;
+
+    // MovingAverage: кольцо окна в общем пуле
+    std::vector<uint32_t> maWindow;
+    std::vector<uint32_t> maOffset;
+    std::vector<uint32_t> maHead;
+    std::vector<uint32_t> maCount;
+    std::vector<double> maSum;
+    std::vector<double> maPool;
+
+    // Median: кольцо окна и отсортированная копия
+    std::vector<uint32_t> medWindow;
+    std::vector<uint32_t> medOffset;
+    std::vector<uint32_t> medHead;
+    std::vector<uint32_t> medCount;
+    std::vector<double> medRing;
+    std::vector<double> medSorted;
+
+    // RateOfChange
+    std::vector<double> rocLast;
+    std::vector<int64_t> rocTime;
+    std::vector<uint8_t> rocPrimed;
+
+    // SpikeReject
+    std::vector<double> spikeMaxStep;
+    std::vector<uint32_t> spikeMaxRejects;
+    std::vector<double> spikeLast;
+    std::vector<uint32_t> spikeRejected;
+    std::vector<uint8_t> spikePrimed;
+
+    std::vector<WorkItem> work[kTypeCount];
+    std::mutex filter_mutex;
+
+    void rebuildIndex();
+    void runEma(TagSample* out);
+    void runMovingAverage(TagSample* out);
+    void runMedian(TagSample* out);
+    void runRateOfChange(TagSample* out);
+    void runSpikeReject(TagSample* out);
+
+public:
+    // Добавляет фильтр в конец цепочки тега
+    bool addFilter(uint32_t tag, const FilterConfig& config, std::string& error);
+    size_t filterCount();
+    bool hasFilters(uint32_t tag);
+
+    // out[k] - обработанный samples[k]; теги без фильтров и отсчёты с
+    // качеством Bad проходят без изменений и не трогают состояние фильтров
+    void process(const TagSample* samples, size_t count, std::vector<TagSample>& out);
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum class ForwardKind : uint8_t {
+    Write = 0,      // запись оператора, должна уйти на сервер
+    Sample = 1      // отсчёт, собранный без связи, должен уйти в историю
+};
+
+struct ForwardRecord {
+    int64_t timestampMs;
+    double value;
+    uint32_t tag;
+    ForwardKind kind;
+    uint8_t quality;
+    uint16_t reserved = 0;
+};
+
+// Буфер "сохранить и переслать" на время обрыва сессии.
+// Записи хранятся в ограниченном кольце в памяти; когда кольцо заполнено,
+// новые записи дописываются в файл-сегмент на диске. Порядок FIFO
+// сохраняется: пока на диске что-то есть, новые записи идут туда же,
+// а кольцо при выдаче подкачивается из файла.
+class StoreForwardBuffer {
+private:
+    std::vector<ForwardRecord> ring;
+    size_t head = 0;
+    size_t count = 0;
+
+    std::string spillPath;
+    std::fstream spill;
+    std::vector<ForwardRecord> spillBuffer;   // буфер дозаписи в файл
+    uint64_t spillWritten = 0;                // записей в файле всего
+    uint64_t spillRead = 0;                   // из них уже подкачано в кольцо
+    uint64_t maxSpillRecords;
+
+    uint64_t dropped = 0;
+    mutable std::mutex buffer_mutex;
+
+    bool openSpill();
+    void flushSpill();
+    void refillFromSpill();
+
+    template <typename Vector>
+    size_t drainInto(size_t maxCount, Vector& out);
+
+public:
+    // maxSpillRecords = 0 - без ограничения размера файла
+    StoreForwardBuffer(size_t ringCapacity, const std::string& spillPath, uint64_t maxSpillRecords = 0);
+    ~StoreForwardBuffer();
+
+    void push(const ForwardRecord* records, size_t n);
+
+    // Выдаёт до maxCount самых старых записей, возвращает их число
+    size_t drain(size_t maxCount, std::vector<ForwardRecord>& out);
+    size_t drain(size_t maxCount, std::pmr::vector<ForwardRecord>& out);
+
+    uint64_t size() const;
+    uint64_t spilledCount() const;
+    uint64_t droppedCount() const;
+};
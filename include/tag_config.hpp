@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Описание тега из конфигурационного файла
+struct TagConfig {
+    std::string name;
+    std::string nodeId;
+    std::string unit;
+    double minVal = 0.0;
+    double maxVal = 100.0;
+    int samplingMs = 1000;
+    std::string expression;   // формула вычисляемого тега, пусто - обычный тег
+};
+
+// Потоковая загрузка описаний тегов из CSV/JSON.
+// Файл читается блоками, числа разбираются через std::from_chars,
+// промежуточные строки на каждую запись не создаются.
+class TagConfigLoader {
+public:
+    // CSV: name,nodeId,unit,min,max,samplingMs[,expression] (строка заголовка необязательна)
+    static bool loadCsv(const std::string& path, std::vector<TagConfig>& out);
+
+    // JSON: [{"name": ..., "nodeId": ..., "unit": ..., "min": ..., "max": ..., "samplingMs": ..., "expression": ...}, ...]
+    // или {"tags": [ ... ]}
+    static bool loadJson(const std::string& path, std::vector<TagConfig>& out);
+
+    // Выбор формата по расширению файла (.json, иначе CSV)
+    static bool loadFile(const std::string& path, std::vector<TagConfig>& out);
+};
@@ -0,0 +1,192 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "node_id.hpp"
+#include "tag_config.hpp"
+
+// Качество значения (вместо строки "GOOD" в каждом теге)
+enum class TagQuality : uint8_t {
+    Good = 0,
+    Uncertain = 1,
+    Bad = 2
+};
+
+const char* qualityToString(TagQuality quality);
+
+// Битовые флаги состояния тега
+enum TagFlags : uint8_t {
+    TAG_FLAG_NONE = 0,
+    TAG_FLAG_WRITTEN = 1 << 0,      // значение записано вручную, симуляция его не трогает
+    TAG_FLAG_CALCULATED = 1 << 1    // значение вычисляется формулой (CalcEngine)
+};
+
+// Один отсчёт потока данных: тег, время, значение, качество
+struct TagSample {
+    uint32_t tag;           // индекс тега в хранилище
+    int64_t timestampMs;
+    double value;
+    TagQuality quality;
+};
+
+// Таблица интернированных строк: каждая строка хранится один раз,
+// теги ссылаются на неё по 32-битному идентификатору.
+// std::deque не перемещает элементы при росте, поэтому string_view
+// на строки таблицы остаются валидными и нуль-терминированными.
+class StringTable {
+private:
+    std::deque<std::string> strings;
+    std::unordered_map<std::string_view, uint32_t> index;
+
+public:
+    static constexpr uint32_t npos = static_cast<uint32_t>(-1);
+
+    uint32_t intern(std::string_view s);
+    uint32_t find(std::string_view s) const;  // без добавления, npos если строки нет
+    std::string_view get(uint32_t id) const { return strings[id]; }
+    size_t size() const { return strings.size(); }
+};
+
+// Согласованное состояние одного тега
+struct TagValue {
+    double value;
+    int64_t timestampMs;
+    TagQuality quality;
+    uint8_t flags;
+};
+
+// Хранилище живых значений без глобальной блокировки.
+// Живые данные лежат массивами (значения, метки времени, качество, флаги),
+// как в исходной SoA-раскладке; рядом - массив счётчиков seqlock, по одному
+// на тег. Писатель делает счётчик тега нечётным, пишет поля и делает его
+// чётным; читатель повторяет чтение, если счётчик изменился. Снимок
+// копирует массивы сегмента подряд и перечитывает только теги, счётчик
+// которых сдвинулся за время копирования. Соседние теги делят кэш-линии,
+// но пишет их в основном один поток опроса, а записи оператора редки.
+// Массивы выделяются сегментами и никогда не перемещаются, поэтому чтение
+// идёт параллельно с добавлением тегов. Метаданные неизменны после
+// публикации тега; индексы поиска по имени и NodeId разбиты на полосы
+// со своими shared_mutex.
+class TagStore {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+private:
+    static constexpr size_t kSegmentBits = 10;
+    static constexpr size_t kSegmentSize = size_t(1) << kSegmentBits;   // тегов в сегменте
+    static constexpr size_t kMaxSegments = 4096;                         // до 4М тегов
+    static constexpr size_t kIndexStripes = 16;
+
+    // Метаданные, записываются один раз до публикации тега
+    struct TagMeta {
+        std::string_view name;
+        std::string_view nodeId;
+        NodeId node;                            // разобранный nodeId
+        std::string_view unit;
+        double minValue = 0.0;
+        double maxValue = 0.0;
+        int32_t samplingMs = 0;
+    };
+
+    // Живые данные сегмента - отдельными массивами
+    struct Segment {
+        std::atomic<uint32_t> seq[kSegmentSize];          // нечётный - идёт запись
+        std::atomic<double> values[kSegmentSize];
+        std::atomic<int64_t> timestamps[kSegmentSize];    // мс от эпохи, 0 - ещё не обновлялся
+        std::atomic<uint8_t> qualities[kSegmentSize];
+        std::atomic<uint8_t> flags[kSegmentSize];
+        TagMeta meta[kSegmentSize];
+
+        Segment();
+    };
+
+    template <typename Key>
+    struct IndexStripe {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<Key, uint32_t> map;
+    };
+
+    std::atomic<Segment*> segments[kMaxSegments] = {};
+    std::atomic<size_t> count{0};
+
+    // Добавление тегов и таблица строк - под add_mutex (редкая операция)
+    std::mutex add_mutex;
+    StringTable strings;
+    IndexStripe<std::string_view> nameStripes[kIndexStripes];
+    IndexStripe<NodeId> nodeIdStripes[kIndexStripes];
+
+    Segment& segment(size_t i) const {
+        return *segments[i >> kSegmentBits].load(std::memory_order_relaxed);
+    }
+    static size_t offset(size_t i) { return i & (kSegmentSize - 1); }
+    const TagMeta& meta(size_t i) const { return segment(i).meta[offset(i)]; }
+
+    // Захват и освобождение seqlock тега писателем
+    static uint32_t lockTag(Segment& s, size_t k);
+    static void unlockTag(Segment& s, size_t k, uint32_t seq);
+
+    bool ensureSegments(size_t tagCount);
+    template <typename Key>
+    static size_t find(const IndexStripe<Key>* stripes, const Key& key);
+    template <typename Key>
+    static void insert(IndexStripe<Key>* stripes, const Key& key, uint32_t index);
+
+public:
+    TagStore() = default;
+    ~TagStore();
+
+    TagStore(const TagStore&) = delete;
+    TagStore& operator=(const TagStore&) = delete;
+
+    void reserve(size_t count);
+
+    // Возвращает индекс нового тега или npos, если имя уже занято
+    size_t add(const TagConfig& cfg);
+
+    size_t size() const { return count.load(std::memory_order_acquire); }
+    size_t findByName(std::string_view name) const;
+    size_t findByNodeId(const NodeId& nodeId) const;
+    size_t findByNodeId(std::string_view nodeId) const { return findByNodeId(NodeId::fromText(nodeId)); }
+
+    std::string_view name(size_t i) const { return meta(i).name; }
+    std::string_view nodeId(size_t i) const { return meta(i).nodeId; }
+    const NodeId& node(size_t i) const { return meta(i).node; }
+    std::string_view unit(size_t i) const { return meta(i).unit; }
+    double minValue(size_t i) const { return meta(i).minValue; }
+    double maxValue(size_t i) const { return meta(i).maxValue; }
+    int samplingInterval(size_t i) const { return meta(i).samplingMs; }
+
+    // Согласованное чтение всех полей тега
+    TagValue load(size_t i) const;
+
+    // Отдельные поля (каждое атомарно, но не согласованы между собой)
+    double value(size_t i) const { return segment(i).values[offset(i)].load(std::memory_order_relaxed); }
+    int64_t timestamp(size_t i) const { return segment(i).timestamps[offset(i)].load(std::memory_order_relaxed); }
+    TagQuality quality(size_t i) const {
+        return static_cast<TagQuality>(segment(i).qualities[offset(i)].load(std::memory_order_relaxed));
+    }
+    uint8_t flagBits(size_t i) const { return segment(i).flags[offset(i)].load(std::memory_order_acquire); }
+    bool isWritten(size_t i) const { return (flagBits(i) & TAG_FLAG_WRITTEN) != 0; }
+    bool isCalculated(size_t i) const { return (flagBits(i) & TAG_FLAG_CALCULATED) != 0; }
+
+    // Публикация нового состояния тега. Писатели одного тега
+    // упорядочиваются на его счётчике, писатели разных тегов не пересекаются.
+    void set(size_t i, double value, int64_t timestampMs, TagQuality quality, uint8_t flagBits);
+    // Публикация отсчёта сбора: проверка TAG_FLAG_WRITTEN и запись идут под
+    // счётчиком тега одной операцией, так что ручная запись, успевшая раньше,
+    // не затирается. Возвращает false, если тег записан вручную.
+    // previous - состояние до записи; флаг CALCULATED сохраняется.
+    bool setUnlessWritten(size_t i, double value, int64_t timestampMs, TagQuality quality,
+                          TagValue& previous);
+    void setFlag(size_t i, uint8_t flag, bool on);
+
+    // Снимок живых данных в буферы вызывающего
+    void snapshot(std::vector<double>& outValues, std::vector<int64_t>& outTimestamps,
+                  std::vector<TagQuality>& outQualities, std::vector<uint8_t>& outFlags) const;
+};
@@ -0,0 +1,135 @@
+#include "../include/address_space.hpp"
+#include <iostream>
+#include <mutex>
+
+using namespace std;
+
+size_t AddressSpaceCache::load(const BrowseService& browse, const TagResolver& resolveTag,
+                               const NodeId& root, size_t maxDepth) {
+    std::vector<BrowseNode> newNodes;
+    std::unordered_map<NodeId, uint32_t> newIndex;
+    size_t newRequests = 0;
+
+    newNodes.push_back({root, "Objects", NodeClass::Object, npos, npos});
+    newIndex.emplace(root, 0);
+
+    // Обход в ширину: один запрос на уровень дерева
+    std::vector<uint32_t> level{0};
+    std::vector<NodeId> request;
+    std::vector<std::vector<BrowseReference>> results;
+
+    for (size_t depth = 0; depth < maxDepth && !level.empty(); depth++) {
+        request.clear();
+        for (uint32_t n : level) {
+            request.push_back(newNodes[n].id);
+        }
+
+        results.clear();
+        if (!browse(request, results)) {
+            cout << "[OPC UA] Browse request failed at depth " << depth << endl;
+            return 0;
+        }
+        newRequests++;
+
+        std::vector<uint32_t> nextLevel;
+        for (size_t k = 0; k < level.size() && k < results.size(); k++) {
+            for (auto& ref : results[k]) {
+                // Узел, достижимый несколькими путями, кэшируется один раз
+                if (newIndex.count(ref.target) > 0) continue;
+
+                uint32_t node = static_cast<uint32_t>(newNodes.size());
+                uint32_t tag = ref.nodeClass == NodeClass::Variable ? resolveTag(ref.target) : npos;
+                newIndex.emplace(ref.target, node);
+                newNodes.push_back({std::move(ref.target), std::move(ref.browseName), ref.nodeClass, level[k], tag});
+                if (ref.nodeClass == NodeClass::Object) {
+                    nextLevel.push_back(node);
+                }
+            }
+        }
+        level.swap(nextLevel);
+    }
+
+    // Потомки в CSR, в порядке обнаружения
+    std::vector<uint32_t> newChildStart(newNodes.size() + 1, 0);
+    for (const auto& node : newNodes) {
+        if (node.parent != npos) newChildStart[node.parent + 1]++;
+    }
+    for (size_t i = 1; i < newChildStart.size(); i++) {
+        newChildStart[i] += newChildStart[i - 1];
+    }
+    std::vector<uint32_t> newChildren(newNodes.size() > 0 ? newNodes.size() - 1 : 0);
+    std::vector<uint32_t> fill(newChildStart.begin(), newChildStart.end() - 1);
+    for (uint32_t i = 0; i < newNodes.size(); i++) {
+        if (newNodes[i].parent != npos) newChildren[fill[newNodes[i].parent]++] = i;
+    }
+
+    size_t count = newNodes.size();
+    {
+        unique_lock<shared_mutex> lock(cache_mutex);
+        nodes.swap(newNodes);
+        childStart.swap(newChildStart);
+        children.swap(newChildren);
+        index.swap(newIndex);
+        requests = newRequests;
+    }
+
+    cout << "[OPC UA] Address space cached: " << count << " nodes in "
+         << newRequests << " browse requests" << endl;
+    return count;
+}
+
+void AddressSpaceCache::clear() {
+    unique_lock<shared_mutex> lock(cache_mutex);
+    nodes.clear();
+    childStart.clear();
+    children.clear();
+    index.clear();
+    requests = 0;
+}
+
+size_t AddressSpaceCache::size() const {
+    shared_lock<shared_mutex> lock(cache_mutex);
+    return nodes.size();
+}
+
+size_t AddressSpaceCache::requestCount() const {
+    shared_lock<shared_mutex> lock(cache_mutex);
+    return requests;
+}
+
+bool AddressSpaceCache::find(const NodeId& id, BrowseNode& out) const {
+    shared_lock<shared_mutex> lock(cache_mutex);
+    auto it = index.find(id);
+    if (it == index.end()) return false;
+    out = nodes[it->second];
+    return true;
+}
+
+uint32_t AddressSpaceCache::resolveTag(const NodeId& id) const {
+    shared_lock<shared_mutex> lock(cache_mutex);
+    auto it = index.find(id);
+    return it != index.end() ? nodes[it->second].tag : npos;
+}
+
+std::vector<BrowseNode> AddressSpaceCache::browse(const NodeId& parent) const {
+    shared_lock<shared_mutex> lock(cache_mutex);
+    std::vector<BrowseNode> out;
+    auto it = index.find(parent);
+    if (it == index.end()) return out;
+
+    uint32_t p = it->second;
+    out.reserve(childStart[p + 1] - childStart[p]);
+    for (uint32_t k = childStart[p]; k < childStart[p + 1]; k++) {
+        out.push_back(nodes[children[k]]);
+    }
+    return out;
+}
+
+std::vector<BrowseNode> AddressSpaceCache::variables() const {
+    shared_lock<shared_mutex> lock(cache_mutex);
+    std::vector<BrowseNode> out;
+    for (const auto& node : nodes) {
+        if (node.nodeClass == NodeClass::Variable) out.push_back(node);
+    }
+    return out;
+}
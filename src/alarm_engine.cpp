@@ -0,0 +1,206 @@
+#include "../include/alarm_engine.hpp"
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace {
+
+const int64_t kNotPending = numeric_limits<int64_t>::min();
+
+}  // namespace
+
+const char* alarmTypeToString(AlarmType type) {
+    switch (type) {
+        case AlarmType::High: return "HIGH";
+        case AlarmType::Low: return "LOW";
+        case AlarmType::RateOfChange: return "ROC";
+    }
+    return "UNKNOWN";
+}
+
+size_t AlarmEngine::addRule(const AlarmRule& rule) {
+    lock_guard<mutex> lock(engine_mutex);
+
+    double sign = rule.type == AlarmType::Low ? -1.0 : 1.0;
+    double deadband = fabs(rule.deadband);
+
+    ruleTag.push_back(rule.tag);
+    ruleType.push_back(rule.type);
+    ruleSign.push_back(sign);
+    raiseLevel.push_back(sign * rule.limit);
+    clearLevel.push_back(sign * rule.limit - deadband);
+    ruleDelay.push_back(rule.delayMs);
+
+    ruleActive.push_back(0);
+    pendingSince.push_back(kNotPending);
+
+    indexDirty = true;
+    return ruleTag.size() - 1;
+}
+
+size_t AlarmEngine::ruleCount() {
+    lock_guard<mutex> lock(engine_mutex);
+    return ruleTag.size();
+}
+
+void AlarmEngine::rebuildIndex() {
+    uint32_t maxTag = 0;
+    for (uint32_t tag : ruleTag) {
+        if (tag + 1 > maxTag) maxTag = tag + 1;
+    }
+
+    // Подсчёт правил на тег и префиксные суммы
+    tagRuleStart.assign(maxTag + 1, 0);
+    for (uint32_t tag : ruleTag) {
+        tagRuleStart[tag + 1]++;
+    }
+    for (size_t t = 1; t < tagRuleStart.size(); t++) {
+        tagRuleStart[t] += tagRuleStart[t - 1];
+    }
+
+    tagRules.resize(ruleTag.size());
+    std::vector<uint32_t> fill(tagRuleStart.begin(), tagRuleStart.end() - 1);
+    for (size_t r = 0; r < ruleTag.size(); r++) {
+        tagRules[fill[ruleTag[r]]++] = static_cast<uint32_t>(r);
+    }
+
+    if (lastValue.size() < maxTag) {
+        lastValue.resize(maxTag, 0.0);
+        lastTime.resize(maxTag, kNotPending);
+    }
+
+    indexDirty = false;
+}
+
+void AlarmEngine::process(const TagSample* samples, size_t count) {
+    lock_guard<mutex> lock(engine_mutex);
+
+    if (ruleTag.empty()) return;
+    if (indexDirty) rebuildIndex();
+
+    const size_t tagLimit = tagRuleStart.size() - 1;
+
+    batchRule.clear();
+    batchX.clear();
+    batchRaise.clear();
+    batchClear.clear();
+    batchTime.clear();
+
+    // 1. Собираем пары (правило, проверяемая величина) только для пришедших отсчётов
+    for (size_t i = 0; i < count; i++) {
+        const TagSample& s = samples[i];
+        if (s.tag >= tagLimit) continue;
+
+        uint32_t begin = tagRuleStart[s.tag];
+        uint32_t end = tagRuleStart[s.tag + 1];
+        if (begin == end) continue;
+
+        bool hasRate = false;
+        double rate = 0.0;
+        if (lastTime[s.tag] != kNotPending && s.timestampMs > lastTime[s.tag]) {
+            rate = fabs(s.value - lastValue[s.tag]) * 1000.0 / double(s.timestampMs - lastTime[s.tag]);
+            hasRate = true;
+        }
+        lastValue[s.tag] = s.value;
+        lastTime[s.tag] = s.timestampMs;
+
+        for (uint32_t k = begin; k < end; k++) {
+            uint32_t r = tagRules[k];
+            double x;
+            if (ruleType[r] == AlarmType::RateOfChange) {
+                if (!hasRate) continue;
+                x = rate;
+            } else {
+                x = s.value;
+            }
+
+            batchRule.push_back(r);
+            batchX.push_back(ruleSign[r] * x);
+            batchRaise.push_back(raiseLevel[r]);
+            batchClear.push_back(clearLevel[r]);
+            batchTime.push_back(s.timestampMs);
+        }
+    }
+
+    // 2. Проверка пределов: непрерывные массивы, без ветвлений (векторизуется)
+    const size_t n = batchRule.size();
+    batchOver.resize(n);
+    batchUnder.resize(n);
+    const double* x = batchX.data();
+    const double* raise = batchRaise.data();
+    const double* clear = batchClear.data();
+    uint8_t* over = batchOver.data();
+    uint8_t* under = batchUnder.data();
+    for (size_t k = 0; k < n; k++) {
+        over[k] = x[k] > raise[k];
+        under[k] = x[k] < clear[k];
+    }
+
+    // 3. Автомат состояний: задержка срабатывания и гистерезис снятия
+    for (size_t k = 0; k < n; k++) {
+        uint32_t r = batchRule[k];
+        int64_t ts = batchTime[k];
+
+        if (!ruleActive[r]) {
+            if (!over[k]) {
+                pendingSince[r] = kNotPending;
+                continue;
+            }
+            if (pendingSince[r] == kNotPending) {
+                pendingSince[r] = ts;
+            }
+            if (ts - pendingSince[r] >= ruleDelay[r]) {
+                ruleActive[r] = 1;
+                pendingSince[r] = kNotPending;
+                emit({r, ruleTag[r], ruleType[r], true, ruleSign[r] * x[k], ts});
+            }
+        } else if (under[k]) {
+            ruleActive[r] = 0;
+            emit({r, ruleTag[r], ruleType[r], false, ruleSign[r] * x[k], ts});
+        }
+    }
+}
+
+void AlarmEngine::emit(const AlarmEvent& event) {
+    lock_guard<mutex> lock(events_mutex);
+    if (events.size() >= maxEvents) {
+        // Очередь ограничена: теряем самое старое событие
+        events.pop_front();
+        droppedEvents++;
+    }
+    events.push_back(event);
+}
+
+size_t AlarmEngine::pollEvents(std::vector<AlarmEvent>& out, size_t maxCount) {
+    lock_guard<mutex> lock(events_mutex);
+    size_t n = 0;
+    while (!events.empty() && n < maxCount) {
+        out.push_back(events.front());
+        events.pop_front();
+        n++;
+    }
+    return n;
+}
+
+bool AlarmEngine::isActive(size_t rule) {
+    lock_guard<mutex> lock(engine_mutex);
+    return rule < ruleActive.size() && ruleActive[rule] != 0;
+}
+
+size_t AlarmEngine::activeCount() {
+    lock_guard<mutex> lock(engine_mutex);
+    size_t n = 0;
+    for (uint8_t a : ruleActive) n += a;
+    return n;
+}
+
+uint64_t AlarmEngine::droppedCount() {
+    lock_guard<mutex> lock(events_mutex);
+    return droppedEvents;
+}
+
+void AlarmEngine::setQueueLimit(size_t limit) {
+    lock_guard<mutex> lock(events_mutex);
+    maxEvents = limit > 0 ? limit : 1;
+}
@@ -0,0 +1,365 @@
+#include "../include/calc_engine.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+
+// Рекурсивный спуск, байткод генерируется сразу в обратной польской записи:
+//   expr    := term (('+' | '-') term)*
+//   term    := unary (('*' | '/') unary)*
+//   unary   := '-' unary | power
+//   power   := primary ('^' unary)?
+//   primary := number | name | name '(' args ')' | '[' name ']' | '(' expr ')'
+class ExpressionCompiler {
+private:
+    const string& text;
+    size_t pos = 0;
+    const CalcEngine::Resolver& resolve;
+    const vector<uint32_t>& tagFormula;
+
+public:
+    vector<CalcInstr> code;
+    vector<double> constants;
+    vector<uint32_t> inputs;
+    string error;
+    int depth = 0;
+    int maxDepth = 0;
+
+    ExpressionCompiler(const string& t, const CalcEngine::Resolver& r, const vector<uint32_t>& tf)
+        : text(t), resolve(r), tagFormula(tf) {}
+
+    bool compile() {
+        if (!parseExpr()) return false;
+        skipSpaces();
+        if (pos != text.size()) return fail("unexpected '" + string(1, text[pos]) + "'");
+        return true;
+    }
+
+private:
+    bool fail(const string& message) {
+        if (error.empty()) {
+            error = message + " at position " + to_string(pos);
+        }
+        return false;
+    }
+
+    void skipSpaces() {
+        while (pos < text.size() && isspace(static_cast<unsigned char>(text[pos]))) pos++;
+    }
+
+    bool accept(char c) {
+        skipSpaces();
+        if (pos < text.size() && text[pos] == c) {
+            pos++;
+            return true;
+        }
+        return false;
+    }
+
+    void emit(CalcOp op, uint32_t arg = 0, int stackDelta = -1) {
+        code.push_back({op, arg});
+        depth += stackDelta;
+        maxDepth = max(maxDepth, depth);
+    }
+
+    bool parseExpr() {
+        if (!parseTerm()) return false;
+        for (;;) {
+            if (accept('+')) {
+                if (!parseTerm()) return false;
+                emit(CalcOp::Add);
+            } else if (accept('-')) {
+                if (!parseTerm()) return false;
+                emit(CalcOp::Sub);
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool parseTerm() {
+        if (!parseUnary()) return false;
+        for (;;) {
+            if (accept('*')) {
+                if (!parseUnary()) return false;
+                emit(CalcOp::Mul);
+            } else if (accept('/')) {
+                if (!parseUnary()) return false;
+                emit(CalcOp::Div);
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool parseUnary() {
+        if (accept('-')) {
+            if (!parseUnary()) return false;
+            emit(CalcOp::Neg, 0, 0);
+            return true;
+        }
+        accept('+');
+        return parsePower();
+    }
+
+    bool parsePower() {
+        if (!parsePrimary()) return false;
+        if (accept('^')) {
+            if (!parseUnary()) return false;
+            emit(CalcOp::Pow);
+        }
+        return true;
+    }
+
+    bool pushTag(const string& name) {
+        size_t index = resolve(name);
+        if (index == TagStore::npos) {
+            return fail("unknown tag '" + name + "'");
+        }
+
+        uint32_t tag = static_cast<uint32_t>(index);
+        if (tag < tagFormula.size() && tagFormula[tag] != CalcEngine::npos) {
+            emit(CalcOp::PushCalc, tagFormula[tag], 1);
+        } else {
+            emit(CalcOp::PushTag, tag, 1);
+        }
+        if (find(inputs.begin(), inputs.end(), tag) == inputs.end()) {
+            inputs.push_back(tag);
+        }
+        return true;
+    }
+
+    bool parseFunction(const string& name) {
+        int args = 0;
+        if (!accept(')')) {
+            do {
+                if (!parseExpr()) return false;
+                args++;
+            } while (accept(','));
+            if (!accept(')')) return fail("expected ')'");
+        }
+
+        if (name == "abs" && args == 1) emit(CalcOp::Abs, 0, 0);
+        else if (name == "sqrt" && args == 1) emit(CalcOp::Sqrt, 0, 0);
+        else if (name == "min" && args == 2) emit(CalcOp::Min);
+        else if (name == "max" && args == 2) emit(CalcOp::Max);
+        else if (name == "pow" && args == 2) emit(CalcOp::Pow);
+        else return fail("unknown function '" + name + "' with " + to_string(args) + " argument(s)");
+        return true;
+    }
+
+    bool parsePrimary() {
+        skipSpaces();
+        if (pos >= text.size()) return fail("unexpected end of expression");
+
+        char c = text[pos];
+
+        if (c == '(') {
+            pos++;
+            if (!parseExpr()) return false;
+            if (!accept(')')) return fail("expected ')'");
+            return true;
+        }
+
+        // Имя тега с пробелами и спецсимволами: [Tag name]
+        if (c == '[') {
+            size_t close = text.find(']', pos + 1);
+            if (close == string::npos) return fail("expected ']'");
+            string name = text.substr(pos + 1, close - pos - 1);
+            pos = close + 1;
+            return pushTag(name);
+        }
+
+        if (isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            double value = 0.0;
+            auto res = from_chars(text.data() + pos, text.data() + text.size(), value);
+            if (res.ec != errc()) return fail("invalid number");
+            pos = res.ptr - text.data();
+            constants.push_back(value);
+            emit(CalcOp::PushConst, static_cast<uint32_t>(constants.size() - 1), 1);
+            return true;
+        }
+
+        if (isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            size_t start = pos;
+            while (pos < text.size() &&
+                   (isalnum(static_cast<unsigned char>(text[pos])) || text[pos] == '_' || text[pos] == '.')) {
+                pos++;
+            }
+            string name = text.substr(start, pos - start);
+            if (accept('(')) {
+                return parseFunction(name);
+            }
+            return pushTag(name);
+        }
+
+        return fail("unexpected '" + string(1, c) + "'");
+    }
+};
+
+}  // namespace
+
+bool CalcEngine::addFormula(uint32_t target, const std::string& expression,
+                            const Resolver& resolve, std::string& error) {
+    if (isCalculated(target)) {
+        error = "tag already has a formula";
+        return false;
+    }
+
+    ExpressionCompiler compiler(expression, resolve, tagFormula);
+    if (!compiler.compile()) {
+        error = compiler.error;
+        return false;
+    }
+    if (find(compiler.inputs.begin(), compiler.inputs.end(), target) != compiler.inputs.end()) {
+        error = "formula refers to its own tag";
+        return false;
+    }
+
+    // Переносим байткод, смещая индексы констант
+    uint32_t constBase = static_cast<uint32_t>(constants.size());
+    uint32_t formula = static_cast<uint32_t>(formulaTarget.size());
+
+    codeBegin.push_back(static_cast<uint32_t>(code.size()));
+    for (CalcInstr instr : compiler.code) {
+        if (instr.op == CalcOp::PushConst) instr.arg += constBase;
+        code.push_back(instr);
+    }
+    codeEnd.push_back(static_cast<uint32_t>(code.size()));
+    constants.insert(constants.end(), compiler.constants.begin(), compiler.constants.end());
+
+    if (inputBegin.empty()) inputBegin.push_back(0);
+    inputTags.insert(inputTags.end(), compiler.inputs.begin(), compiler.inputs.end());
+    inputBegin.push_back(static_cast<uint32_t>(inputTags.size()));
+
+    formulaTarget.push_back(target);
+    formulaValue.push_back(0.0);
+    formulaQuality.push_back(TagQuality::Good);
+    queued.push_back(0);
+
+    if (tagFormula.size() <= target) tagFormula.resize(target + 1, npos);
+    tagFormula[target] = formula;
+
+    maxDepth = max(maxDepth, static_cast<size_t>(compiler.maxDepth));
+    indexDirty = true;
+    return true;
+}
+
+bool CalcEngine::isCalculated(uint32_t tag) const {
+    return tag < tagFormula.size() && tagFormula[tag] != npos;
+}
+
+void CalcEngine::rebuildIndex() {
+    uint32_t maxTag = 0;
+    for (uint32_t tag : inputTags) maxTag = max(maxTag, tag + 1);
+
+    dependentStart.assign(maxTag + 1, 0);
+    for (uint32_t tag : inputTags) dependentStart[tag + 1]++;
+    for (size_t t = 1; t < dependentStart.size(); t++) dependentStart[t] += dependentStart[t - 1];
+
+    dependents.resize(inputTags.size());
+    vector<uint32_t> fill(dependentStart.begin(), dependentStart.end() - 1);
+    for (uint32_t f = 0; f < formulaTarget.size(); f++) {
+        for (uint32_t k = inputBegin[f]; k < inputBegin[f + 1]; k++) {
+            dependents[fill[inputTags[k]]++] = f;
+        }
+    }
+
+    stack.resize(maxDepth + 1);
+    indexDirty = false;
+}
+
+void CalcEngine::markDependents(uint32_t tag) {
+    if (tag + 1 >= dependentStart.size()) return;
+    for (uint32_t k = dependentStart[tag]; k < dependentStart[tag + 1]; k++) {
+        uint32_t f = dependents[k];
+        if (!queued[f]) {
+            queued[f] = 1;
+            pending.push_back(f);
+            push_heap(pending.begin(), pending.end(), greater<uint32_t>());
+        }
+    }
+}
+
+double CalcEngine::run(uint32_t formula, const TagStore& store, TagQuality& quality) {
+    double* sp = stack.data();   // указатель на следующий свободный слот
+    quality = TagQuality::Good;
+
+    for (uint32_t ip = codeBegin[formula]; ip < codeEnd[formula]; ip++) {
+        const CalcInstr& in = code[ip];
+        switch (in.op) {
+            case CalcOp::PushConst:
+                *sp++ = constants[in.arg];
+                break;
+            case CalcOp::PushTag: {
+                TagValue input = store.load(in.arg);
+                *sp++ = input.value;
+                quality = max(quality, input.quality);
+                break;
+            }
+            case CalcOp::PushCalc:
+                *sp++ = formulaValue[in.arg];
+                quality = max(quality, formulaQuality[in.arg]);
+                break;
+            case CalcOp::Add: sp--; sp[-1] += sp[0]; break;
+            case CalcOp::Sub: sp--; sp[-1] -= sp[0]; break;
+            case CalcOp::Mul: sp--; sp[-1] *= sp[0]; break;
+            case CalcOp::Div: sp--; sp[-1] /= sp[0]; break;
+            case CalcOp::Pow: sp--; sp[-1] = pow(sp[-1], sp[0]); break;
+            case CalcOp::Min: sp--; sp[-1] = min(sp[-1], sp[0]); break;
+            case CalcOp::Max: sp--; sp[-1] = max(sp[-1], sp[0]); break;
+            case CalcOp::Neg: sp[-1] = -sp[-1]; break;
+            case CalcOp::Abs: sp[-1] = fabs(sp[-1]); break;
+            case CalcOp::Sqrt: sp[-1] = sqrt(sp[-1]); break;
+        }
+    }
+
+    double result = sp[-1];
+    if (!isfinite(result)) {
+        quality = TagQuality::Bad;
+    }
+    return result;
+}
+
+void CalcEngine::evaluate(const TagStore& store, const TagSample* changed, size_t count,
+                          std::vector<TagSample>& out) {
+    if (formulaTarget.empty() || count == 0) return;
+    if (indexDirty) rebuildIndex();
+
+    int64_t timestamp = 0;
+    for (size_t i = 0; i < count; i++) {
+        markDependents(changed[i].tag);
+        timestamp = max(timestamp, changed[i].timestampMs);
+    }
+
+    // Индекс формулы совпадает с топологическим номером:
+    // формула всегда добавляется после своих входов
+    while (!pending.empty()) {
+        pop_heap(pending.begin(), pending.end(), greater<uint32_t>());
+        uint32_t f = pending.back();
+        pending.pop_back();
+        queued[f] = 0;
+
+        TagQuality quality;
+        formulaValue[f] = run(f, store, quality);
+        formulaQuality[f] = quality;
+        out.push_back({formulaTarget[f], timestamp, formulaValue[f], quality});
+
+        markDependents(formulaTarget[f]);
+    }
+}
+
+void CalcEngine::evaluateAll(const TagStore& store, int64_t timestampMs, std::vector<TagSample>& out) {
+    if (indexDirty) rebuildIndex();
+
+    for (uint32_t f = 0; f < formulaTarget.size(); f++) {
+        TagQuality quality;
+        formulaValue[f] = run(f, store, quality);
+        formulaQuality[f] = quality;
+        out.push_back({formulaTarget[f], timestampMs, formulaValue[f], quality});
+    }
+}
@@ -0,0 +1,97 @@
+#include "../include/event_loop.hpp"
+
+using namespace std;
+
+const char* asyncStatusToString(AsyncStatus status) {
+    switch (status) {
+        case AsyncStatus::Pending: return "PENDING";
+        case AsyncStatus::Completed: return "COMPLETED";
+        case AsyncStatus::Failed: return "FAILED";
+        case AsyncStatus::TimedOut: return "TIMED OUT";
+        case AsyncStatus::Cancelled: return "CANCELLED";
+    }
+    return "UNKNOWN";
+}
+
+EventLoop::EventLoop() {
+    worker = thread(&EventLoop::run, this);
+}
+
+EventLoop::~EventLoop() {
+    stop();
+}
+
+void EventLoop::stop() {
+    {
+        lock_guard<mutex> lock(loop_mutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    wakeup.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void EventLoop::post(Task task) {
+    {
+        lock_guard<mutex> lock(loop_mutex);
+        if (stopping) return;
+        tasks.push_back(std::move(task));
+    }
+    wakeup.notify_one();
+}
+
+uint64_t EventLoop::schedule(std::chrono::milliseconds delay, Task task) {
+    uint64_t id;
+    {
+        lock_guard<mutex> lock(loop_mutex);
+        if (stopping) return 0;
+        id = nextTimerId++;
+        activeTimers.insert(id);
+        timers.push({Clock::now() + delay, id, std::move(task)});
+    }
+    wakeup.notify_one();
+    return id;
+}
+
+void EventLoop::cancelTimer(uint64_t id) {
+    if (id == 0) return;
+    lock_guard<mutex> lock(loop_mutex);
+    // Уже сработавший таймер отменять нечего
+    if (activeTimers.erase(id) > 0) {
+        cancelledTimers.insert(id);
+    }
+}
+
+void EventLoop::run() {
+    unique_lock<mutex> lock(loop_mutex);
+
+    while (!stopping) {
+        // Сработавшие таймеры переносим в очередь задач
+        auto now = Clock::now();
+        while (!timers.empty() && timers.top().due <= now) {
+            Timer timer = timers.top();
+            timers.pop();
+            if (cancelledTimers.erase(timer.id) == 0) {
+                activeTimers.erase(timer.id);
+                tasks.push_back(std::move(timer.task));
+            }
+        }
+
+        if (!tasks.empty()) {
+            Task task = std::move(tasks.front());
+            tasks.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+            continue;
+        }
+
+        if (timers.empty()) {
+            wakeup.wait(lock);
+        } else {
+            wakeup.wait_until(lock, timers.top().due);
+        }
+    }
+}
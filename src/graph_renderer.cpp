@@ -9,6 +9,10 @@ void GraphRenderer::setData(const std::vector<double>& newData) {
     data = newData;
 }
 
+void GraphRenderer::setRawData(const std::vector<double>& newRawData) {
+    rawData = newRawData;
+}
+
 void GraphRenderer::render(HDC hdc, RECT clientRect) {
     if (data.empty()) return;
     
@@ -22,7 +26,18 @@ void GraphRenderer::render(HDC hdc, RECT clientRect) {
     
     double minVal = *std::min_element(data.begin(), data.end());
     double maxVal = *std::max_element(data.begin(), data.end());
-    double range = maxVal - minVal;
+    
+    // Общая шкала для обработанного и исходного рядов
+    double scaleMin = minVal;
+    double scaleMax = maxVal;
+    if (!rawData.empty()) {
+        // Без std::min/std::max: <windows.h> определяет одноимённые макросы
+        double rawMin = *std::min_element(rawData.begin(), rawData.end());
+        double rawMax = *std::max_element(rawData.begin(), rawData.end());
+        if (rawMin < scaleMin) scaleMin = rawMin;
+        if (rawMax > scaleMax) scaleMax = rawMax;
+    }
+    double range = scaleMax - scaleMin;
     if (range == 0) range = 1;
     
     // Сетка
@@ -44,6 +59,28 @@ void GraphRenderer::render(HDC hdc, RECT clientRect) {
     SelectObject(hdc, hOldPen);
     DeleteObject(hGridPen);
     
+    // Исходный ряд - тонкой линией под основным
+    if (rawData.size() > 1) {
+        HPEN hRawPen = CreatePen(PS_SOLID, 1, rawLineColor);
+        SelectObject(hdc, hRawPen);
+        
+        for (size_t i = 1; i < rawData.size(); i++) {
+            int x1 = margin + (int)((double)(i-1) / (rawData.size()-1) * graphWidth);
+            int y1 = clientRect.bottom - margin - 
+                    (int)((rawData[i-1] - scaleMin) / range * graphHeight);
+            
+            int x2 = margin + (int)((double)i / (rawData.size()-1) * graphWidth);
+            int y2 = clientRect.bottom - margin - 
+                    (int)((rawData[i] - scaleMin) / range * graphHeight);
+            
+            MoveToEx(hdc, x1, y1, NULL);
+            LineTo(hdc, x2, y2);
+        }
+        
+        SelectObject(hdc, hOldPen);
+        DeleteObject(hRawPen);
+    }
+    
     // Линия графика
     HPEN hLinePen = CreatePen(PS_SOLID, 2, lineColor);
     SelectObject(hdc, hLinePen);
@@ -51,11 +88,11 @@ void GraphRenderer::render(HDC hdc, RECT clientRect) {
     for (size_t i = 1; i < data.size(); i++) {
         int x1 = margin + (int)((double)(i-1) / (data.size()-1) * graphWidth);
         int y1 = clientRect.bottom - margin - 
-                (int)((data[i-1] - minVal) / range * graphHeight);
+                (int)((data[i-1] - scaleMin) / range * graphHeight);
         
         int x2 = margin + (int)((double)i / (data.size()-1) * graphWidth);
         int y2 = clientRect.bottom - margin - 
-                (int)((data[i] - minVal) / range * graphHeight);
+                (int)((data[i] - scaleMin) / range * graphHeight);
         
         MoveToEx(hdc, x1, y1, NULL);
         LineTo(hdc, x2, y2);
@@ -71,7 +108,7 @@ void GraphRenderer::render(HDC hdc, RECT clientRect) {
     for (size_t i = 0; i < data.size(); i++) {
         int x = margin + (int)((double)i / (data.size()-1) * graphWidth);
         int y = clientRect.bottom - margin - 
-               (int)((data[i] - minVal) / range * graphHeight);
+               (int)((data[i] - scaleMin) / range * graphHeight);
         
         Ellipse(hdc, x-3, y-3, x+3, y+3);
     }
@@ -88,6 +125,9 @@ void GraphRenderer::render(HDC hdc, RECT clientRect) {
     HFONT hOldFont = (HFONT)SelectObject(hdc, hFont);
     
     std::string fullTitle = title + " (" + unit + ")";
+    if (!rawData.empty()) {
+        fullTitle += " - filtered / raw";
+    }
     TextOut(hdc, margin, 10, fullTitle.c_str(), fullTitle.length());
     
     SelectObject(hdc, hOldFont);
@@ -104,4 +144,5 @@ void GraphRenderer::render(HDC hdc, RECT clientRect) {
 
 void GraphRenderer::clear() {
     data.clear();
+    rawData.clear();
 }
\ No newline at end of file
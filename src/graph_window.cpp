@@ -1,5 +1,6 @@
 #include <windows.h>
 #include <string>
+#include <vector>
 #include "../include/opcua_client.hpp"
 #include "../include/graph_renderer.hpp"
 
@@ -12,12 +13,15 @@ LRESULT CALLBACK GraphWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
         case WM_CREATE: {
             auto tagPtr = g_client.getTagByName(g_currentTagName);
             if (tagPtr) {
-                g_pGraphRenderer = new GraphRenderer(hWnd, tagPtr->name, tagPtr->unit);
+                g_pGraphRenderer = new GraphRenderer(hWnd, std::string(tagPtr->name), std::string(tagPtr->unit));
                 
-                auto history = g_client.getTagHistory(g_currentTagName);
-                if (history) {
-                    g_pGraphRenderer->setData(history->values);
+                std::vector<double> history;
+                if (g_client.getHistoryValues(g_currentTagName, history)) {
+                    g_pGraphRenderer->setData(history);
                 }
+                std::vector<double> raw;
+                g_client.getRawHistoryValues(g_currentTagName, raw);
+                g_pGraphRenderer->setRawData(raw);
             }
             break;
         }
@@ -46,9 +50,12 @@ LRESULT CALLBACK GraphWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
             
         case WM_TIMER:
             if (wParam == 1) {
-                auto history = g_client.getTagHistory(g_currentTagName);
-                if (history && g_pGraphRenderer) {
-                    g_pGraphRenderer->setData(history->values);
+                std::vector<double> history;
+                if (g_pGraphRenderer && g_client.getHistoryValues(g_currentTagName, history)) {
+                    std::vector<double> raw;
+                    g_client.getRawHistoryValues(g_currentTagName, raw);
+                    g_pGraphRenderer->setData(history);
+                    g_pGraphRenderer->setRawData(raw);
                     InvalidateRect(hWnd, NULL, TRUE);
                 }
             }
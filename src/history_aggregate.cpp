@@ -0,0 +1,232 @@
+#include "../include/history_aggregate.hpp"
+#include "../include/opcua_client.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+const double kNoData = numeric_limits<double>::quiet_NaN();
+
+// Сумма, минимум и максимум участка: четыре независимых аккумулятора,
+// чтобы цепочки зависимостей не мешали конвейеру и векторизации
+void reduceSpan(const double* v, size_t n, double& sum, double& mn, double& mx) {
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    double lo0 = mn, lo1 = mn, lo2 = mn, lo3 = mn;
+    double hi0 = mx, hi1 = mx, hi2 = mx, hi3 = mx;
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += v[i]; s1 += v[i + 1]; s2 += v[i + 2]; s3 += v[i + 3];
+        lo0 = v[i] < lo0 ? v[i] : lo0;
+        lo1 = v[i + 1] < lo1 ? v[i + 1] : lo1;
+        lo2 = v[i + 2] < lo2 ? v[i + 2] : lo2;
+        lo3 = v[i + 3] < lo3 ? v[i + 3] : lo3;
+        hi0 = v[i] > hi0 ? v[i] : hi0;
+        hi1 = v[i + 1] > hi1 ? v[i + 1] : hi1;
+        hi2 = v[i + 2] > hi2 ? v[i + 2] : hi2;
+        hi3 = v[i + 3] > hi3 ? v[i + 3] : hi3;
+    }
+    for (; i < n; i++) {
+        s0 += v[i];
+        lo0 = v[i] < lo0 ? v[i] : lo0;
+        hi0 = v[i] > hi0 ? v[i] : hi0;
+    }
+
+    sum += (s0 + s1) + (s2 + s3);
+    mn = min(min(lo0, lo1), min(lo2, lo3));
+    mx = max(max(hi0, hi1), max(hi2, hi3));
+}
+
+// Сумма v[k-1] * (t[k] - t[k-1]) по участку: ступенчатый интеграл
+double weightedSpan(const double* v, const int64_t* t, size_t n) {
+    double w0 = 0, w1 = 0;
+    size_t k = 1;
+    for (; k + 2 <= n; k += 2) {
+        w0 += v[k - 1] * static_cast<double>(t[k] - t[k - 1]);
+        w1 += v[k] * static_cast<double>(t[k + 1] - t[k]);
+    }
+    for (; k < n; k++) {
+        w0 += v[k - 1] * static_cast<double>(t[k] - t[k - 1]);
+    }
+    return w0 + w1;
+}
+
+}  // namespace
+
+HistoryAggregator::HistoryAggregator(OPCUAClient& c, size_t chunk, size_t threadCount)
+    : client(c), chunkSize(chunk > 0 ? chunk : 1), threads(threadCount) {
+    if (threads == 0) {
+        threads = max<size_t>(thread::hardware_concurrency(), 1);
+    }
+}
+
+bool HistoryAggregator::query(const std::vector<std::string>& tagNames, int64_t startMs, int64_t endMs,
+                              int64_t intervalMs, uint32_t flags, std::vector<AggregateSeries>& out) {
+    if (intervalMs <= 0 || endMs <= startMs) {
+        cout << "[OPC UA] Aggregate error: invalid time range" << endl;
+        return false;
+    }
+    auto started = chrono::steady_clock::now();
+
+    size_t intervals = static_cast<size_t>((endMs - startMs + intervalMs - 1) / intervalMs);
+    out.assign(tagNames.size(), AggregateSeries());
+    for (size_t i = 0; i < tagNames.size(); i++) {
+        out[i].tag = tagNames[i];
+        out[i].startMs = startMs;
+        out[i].intervalMs = intervalMs;
+        out[i].intervals = intervals;
+    }
+
+    // Потоки разбирают теги по одному через общий счётчик
+    atomic<size_t> next{0};
+    auto worker = [&]() {
+        Scratch scratch;
+        scratch.values.resize(chunkSize);
+        scratch.timestamps.resize(chunkSize);
+        for (size_t i = next++; i < out.size(); i = next++) {
+            aggregateTag(out[i], endMs, flags, scratch);
+        }
+    };
+
+    size_t workerCount = min(threads, tagNames.size());
+    vector<thread> pool;
+    for (size_t w = 1; w < workerCount; w++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : pool) {
+        t.join();
+    }
+
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - started);
+    cout << "[OPC UA] Aggregated " << tagNames.size() << " tags x " << intervals
+         << " intervals in " << elapsed.count() << " ms" << endl;
+    return true;
+}
+
+void HistoryAggregator::aggregateTag(AggregateSeries& series, int64_t endMs, uint32_t flags, Scratch& scratch) {
+    const int64_t start = series.startMs;
+    const int64_t interval = series.intervalMs;
+    const size_t intervals = series.intervals;
+    const bool timeAverage = (flags & AGGREGATE_TIME_AVERAGE) != 0;
+
+    std::vector<uint32_t> count(intervals, 0);
+    std::vector<double> minimum(intervals, numeric_limits<double>::infinity());
+    std::vector<double> maximum(intervals, -numeric_limits<double>::infinity());
+    scratch.sum.assign(intervals, 0.0);
+    if (timeAverage) {
+        scratch.weighted.assign(intervals, 0.0);
+        scratch.covered.assign(intervals, 0);
+    }
+
+    // Ступенчатый участок [a, b) со значением v, разнесённый по интервалам
+    auto addSegment = [&](int64_t a, int64_t b, double v) {
+        a = max(a, start);
+        b = min(b, endMs);
+        while (a < b) {
+            size_t k = static_cast<size_t>((a - start) / interval);
+            int64_t e = min(b, start + static_cast<int64_t>(k + 1) * interval);
+            scratch.weighted[k] += v * static_cast<double>(e - a);
+            scratch.covered[k] += e - a;
+            a = e;
+        }
+    };
+
+    bool havePrev = false;
+    int64_t prevTs = 0;
+    double prevValue = 0.0;
+
+    uint64_t seq = 0;
+    uint64_t endSeq = 0;
+    series.found = client.getHistoryRange(series.tag, seq, endSeq);
+    bool done = !series.found;
+
+    while (!done) {
+        size_t n = client.readHistory(series.tag, seq, endSeq, chunkSize,
+                                      scratch.values.data(), scratch.timestamps.data());
+        if (n == 0) break;
+        const double* v = scratch.values.data();
+        const int64_t* t = scratch.timestamps.data();
+
+        size_t k = 0;
+        while (k < n) {
+            // Метка 0 - значение до первого обновления, данных нет
+            if (t[k] <= 0 || t[k] < start) {
+                if (t[k] > 0) {
+                    havePrev = true;
+                    prevTs = t[k];
+                    prevValue = v[k];
+                }
+                k++;
+                continue;
+            }
+            if (t[k] >= endMs) {
+                done = true;
+                break;
+            }
+
+            // Участок [k, j) целиком в одном интервале
+            size_t bucket = static_cast<size_t>((t[k] - start) / interval);
+            int64_t bucketEnd = min(endMs, start + static_cast<int64_t>(bucket + 1) * interval);
+            size_t j = static_cast<size_t>(lower_bound(t + k, t + n, bucketEnd) - t);
+
+            double lo = minimum[bucket];
+            double hi = maximum[bucket];
+            reduceSpan(v + k, j - k, scratch.sum[bucket], lo, hi);
+            minimum[bucket] = lo;
+            maximum[bucket] = hi;
+            count[bucket] += static_cast<uint32_t>(j - k);
+
+            if (timeAverage) {
+                if (havePrev) addSegment(prevTs, t[k], prevValue);
+                scratch.weighted[bucket] += weightedSpan(v + k, t + k, j - k);
+                scratch.covered[bucket] += t[j - 1] - t[k];
+            }
+
+            havePrev = true;
+            prevTs = t[j - 1];
+            prevValue = v[j - 1];
+            k = j;
+        }
+    }
+    if (timeAverage && havePrev) {
+        addSegment(prevTs, endMs, prevValue);
+    }
+
+    // Компактные массивы только запрошенных агрегатов
+    if (flags & AGGREGATE_AVERAGE) {
+        series.average.resize(intervals);
+        for (size_t b = 0; b < intervals; b++) {
+            series.average[b] = count[b] > 0 ? scratch.sum[b] / count[b] : kNoData;
+        }
+    }
+    if (flags & AGGREGATE_MINIMUM) {
+        series.minimum.resize(intervals);
+        for (size_t b = 0; b < intervals; b++) {
+            series.minimum[b] = count[b] > 0 ? minimum[b] : kNoData;
+        }
+    }
+    if (flags & AGGREGATE_MAXIMUM) {
+        series.maximum.resize(intervals);
+        for (size_t b = 0; b < intervals; b++) {
+            series.maximum[b] = count[b] > 0 ? maximum[b] : kNoData;
+        }
+    }
+    if (flags & AGGREGATE_COUNT) {
+        series.count.swap(count);
+    }
+    if (timeAverage) {
+        series.timeAverage.resize(intervals);
+        for (size_t b = 0; b < intervals; b++) {
+            series.timeAverage[b] = scratch.covered[b] > 0
+                ? scratch.weighted[b] / static_cast<double>(scratch.covered[b]) : kNoData;
+        }
+    }
+}
@@ -0,0 +1,163 @@
+#include "../include/history_export.hpp"
+#include "../include/opcua_client.hpp"
+#include <charconv>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+const char kColumnarMagic[8] = {'O', 'P', 'C', 'H', 'I', 'S', 'T', '1'};
+const uint32_t kColumnarVersion = 1;
+
+// Максимальная длина строки CSV без имени тега:
+// запятые, int64 метка времени, double в кратчайшей записи, перевод строки
+const size_t kMaxCsvNumbers = 64;
+
+string csvEscape(const string& name) {
+    if (name.find_first_of(",\"\n") == string::npos) {
+        return name;
+    }
+    string quoted = "\"";
+    for (char c : name) {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    quoted += '"';
+    return quoted;
+}
+
+}  // namespace
+
+HistoryExporter::HistoryExporter(OPCUAClient& c, size_t chunk, size_t writeBufferSize)
+    : client(c), chunkSize(chunk > 0 ? chunk : 1),
+      chunkValues(chunkSize), chunkTimestamps(chunkSize), out(writeBufferSize) {}
+
+bool HistoryExporter::openFile(const std::string& path) {
+    file.clear();
+    file.open(path, ios::binary | ios::trunc);
+    if (!file) {
+        cout << "[OPC UA] Export error: cannot create " << path << endl;
+        return false;
+    }
+    outUsed = 0;
+    exported = 0;
+    return true;
+}
+
+bool HistoryExporter::finishFile(const std::string& path) {
+    flushOut();
+    file.close();
+    if (!file) {
+        cout << "[OPC UA] Export error: write to " << path << " failed" << endl;
+        return false;
+    }
+    cout << "[OPC UA] Exported " << exported << " samples to " << path << endl;
+    return true;
+}
+
+void HistoryExporter::flushOut() {
+    if (outUsed > 0) {
+        file.write(out.data(), outUsed);
+        outUsed = 0;
+    }
+}
+
+void HistoryExporter::put(const char* data, size_t size) {
+    if (size > out.size() - outUsed) {
+        flushOut();
+        // Блок больше буфера целиком - пишем напрямую
+        if (size > out.size()) {
+            file.write(data, size);
+            return;
+        }
+    }
+    memcpy(out.data() + outUsed, data, size);
+    outUsed += size;
+}
+
+bool HistoryExporter::exportCsv(const std::string& path, const std::vector<std::string>& tagNames) {
+    if (!openFile(path)) return false;
+
+    const char header[] = "tag,timestamp_ms,value\n";
+    put(header, sizeof(header) - 1);
+
+    for (const auto& name : tagNames) {
+        uint64_t seq = 0;
+        uint64_t endSeq = 0;
+        if (!client.getHistoryRange(name, seq, endSeq)) continue;
+
+        const string prefix = csvEscape(name) + ",";
+        const size_t maxLine = prefix.size() + kMaxCsvNumbers;
+        if (maxLine > out.size()) continue;   // имя длиннее буфера записи
+
+        for (;;) {
+            size_t n = client.readHistory(name, seq, endSeq, chunkSize,
+                                          chunkValues.data(), chunkTimestamps.data());
+            if (n == 0) break;
+
+            for (size_t i = 0; i < n; i++) {
+                // Метка 0 - значение до первого обновления, данных нет
+                if (chunkTimestamps[i] <= 0) continue;
+                if (out.size() - outUsed < maxLine) flushOut();
+
+                char* p = out.data() + outUsed;
+                char* end = out.data() + out.size();
+                memcpy(p, prefix.data(), prefix.size());
+                p += prefix.size();
+                p = to_chars(p, end, chunkTimestamps[i]).ptr;
+                *p++ = ',';
+                p = to_chars(p, end, chunkValues[i]).ptr;
+                *p++ = '\n';
+                outUsed = p - out.data();
+                exported++;
+            }
+        }
+    }
+
+    return finishFile(path);
+}
+
+bool HistoryExporter::exportColumnar(const std::string& path, const std::vector<std::string>& tagNames) {
+    if (!openFile(path)) return false;
+
+    put(kColumnarMagic, sizeof(kColumnarMagic));
+    put(reinterpret_cast<const char*>(&kColumnarVersion), sizeof(kColumnarVersion));
+
+    for (const auto& name : tagNames) {
+        uint64_t seq = 0;
+        uint64_t endSeq = 0;
+        if (!client.getHistoryRange(name, seq, endSeq)) continue;
+
+        uint16_t nameLen = static_cast<uint16_t>(min<size_t>(name.size(), UINT16_MAX));
+
+        for (;;) {
+            size_t n = client.readHistory(name, seq, endSeq, chunkSize,
+                                          chunkValues.data(), chunkTimestamps.data());
+            if (n == 0) break;
+
+            // Записи без данных (метка 0) выбрасываются, остальные сдвигаются к началу
+            size_t kept = 0;
+            for (size_t i = 0; i < n; i++) {
+                if (chunkTimestamps[i] <= 0) continue;
+                chunkTimestamps[kept] = chunkTimestamps[i];
+                chunkValues[kept] = chunkValues[i];
+                kept++;
+            }
+            if (kept == 0) continue;
+            n = kept;
+
+            // Один блок на кусок: метки времени и значения отдельными колонками
+            uint32_t count = static_cast<uint32_t>(n);
+            put(reinterpret_cast<const char*>(&nameLen), sizeof(nameLen));
+            put(name.data(), nameLen);
+            put(reinterpret_cast<const char*>(&count), sizeof(count));
+            put(reinterpret_cast<const char*>(chunkTimestamps.data()), n * sizeof(int64_t));
+            put(reinterpret_cast<const char*>(chunkValues.data()), n * sizeof(double));
+            exported += n;
+        }
+    }
+
+    return finishFile(path);
+}
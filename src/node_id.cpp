@@ -0,0 +1,194 @@
+#include "../include/node_id.hpp"
+#include <charconv>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+const char kHexDigits[] = "0123456789abcdef";
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Ровно count шестнадцатеричных цифр начиная с pos
+template <typename T>
+bool parseHex(string_view text, size_t pos, size_t count, T& out) {
+    if (pos + count > text.size()) return false;
+    uint64_t v = 0;
+    for (size_t i = 0; i < count; i++) {
+        int d = hexValue(text[pos + i]);
+        if (d < 0) return false;
+        v = (v << 4) | static_cast<uint64_t>(d);
+    }
+    out = static_cast<T>(v);
+    return true;
+}
+
+bool parseGuid(string_view text, NodeGuid& out) {
+    // xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx
+    if (text.size() != 36 || text[8] != '-' || text[13] != '-' || text[18] != '-' || text[23] != '-') {
+        return false;
+    }
+    if (!parseHex(text, 0, 8, out.data1) || !parseHex(text, 9, 4, out.data2) || !parseHex(text, 14, 4, out.data3)) {
+        return false;
+    }
+    for (size_t i = 0; i < 8; i++) {
+        size_t pos = i < 2 ? 19 + i * 2 : 24 + (i - 2) * 2;
+        if (!parseHex(text, pos, 2, out.data4[i])) return false;
+    }
+    return true;
+}
+
+void appendHex(string& out, uint64_t v, size_t digits) {
+    for (size_t i = digits; i-- > 0;) {
+        out += kHexDigits[(v >> (i * 4)) & 0xF];
+    }
+}
+
+size_t mix(size_t seed, size_t v) {
+    return seed ^ (v + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+}  // namespace
+
+NodeId NodeId::numeric(uint16_t ns, uint32_t id) {
+    NodeId n;
+    n.ns = ns;
+    n.idType = NodeIdType::Numeric;
+    n.numericId = id;
+    return n;
+}
+
+NodeId NodeId::string(uint16_t ns, std::string_view id) {
+    NodeId n;
+    n.ns = ns;
+    n.idType = NodeIdType::String;
+    n.stringId.assign(id);
+    return n;
+}
+
+NodeId NodeId::guid(uint16_t ns, const NodeGuid& id) {
+    NodeId n;
+    n.ns = ns;
+    n.idType = NodeIdType::Guid;
+    n.guidId = id;
+    return n;
+}
+
+bool NodeId::parse(std::string_view text, NodeId& out) {
+    uint16_t nsIndex = 0;
+
+    if (text.compare(0, 3, "ns=") == 0) {
+        size_t semicolon = text.find(';');
+        if (semicolon == string_view::npos) return false;
+        auto res = from_chars(text.data() + 3, text.data() + semicolon, nsIndex);
+        if (res.ec != errc() || res.ptr != text.data() + semicolon) return false;
+        text.remove_prefix(semicolon + 1);
+    }
+
+    if (text.size() < 2 || text[1] != '=') return false;
+    string_view id = text.substr(2);
+
+    switch (text[0]) {
+        case 'i': {
+            uint32_t value = 0;
+            auto res = from_chars(id.data(), id.data() + id.size(), value);
+            if (id.empty() || res.ec != errc() || res.ptr != id.data() + id.size()) return false;
+            out = numeric(nsIndex, value);
+            return true;
+        }
+        case 's':
+            out = string(nsIndex, id);
+            return true;
+        case 'g': {
+            NodeGuid g;
+            if (!parseGuid(id, g)) return false;
+            out = guid(nsIndex, g);
+            return true;
+        }
+    }
+    return false;
+}
+
+NodeId NodeId::fromText(std::string_view text) {
+    NodeId id;
+    if (!parse(text, id)) {
+        id = string(0, text);
+    }
+    return id;
+}
+
+std::string NodeId::toString() const {
+    std::string out;
+    if (ns != 0) {
+        out = "ns=" + to_string(ns) + ";";
+    }
+    switch (idType) {
+        case NodeIdType::Numeric:
+            out += "i=" + to_string(numericId);
+            break;
+        case NodeIdType::String:
+            out += "s=" + stringId;
+            break;
+        case NodeIdType::Guid:
+            out += "g=";
+            appendHex(out, guidId.data1, 8);
+            out += '-';
+            appendHex(out, guidId.data2, 4);
+            out += '-';
+            appendHex(out, guidId.data3, 4);
+            out += '-';
+            for (size_t i = 0; i < 8; i++) {
+                if (i == 2) out += '-';
+                appendHex(out, guidId.data4[i], 2);
+            }
+            break;
+    }
+    return out;
+}
+
+size_t NodeId::hash() const {
+    size_t h = (static_cast<size_t>(ns) << 8) | static_cast<size_t>(idType);
+    switch (idType) {
+        case NodeIdType::Numeric:
+            return mix(h, numericId);
+        case NodeIdType::String:
+            return mix(h, std::hash<std::string>()(stringId));
+        case NodeIdType::Guid: {
+            uint64_t lo;
+            uint64_t hi;
+            memcpy(&lo, &guidId.data1, 4);
+            memcpy(reinterpret_cast<char*>(&lo) + 4, &guidId.data2, 2);
+            memcpy(reinterpret_cast<char*>(&lo) + 6, &guidId.data3, 2);
+            memcpy(&hi, guidId.data4, 8);
+            return mix(mix(h, static_cast<size_t>(lo)), static_cast<size_t>(hi));
+        }
+    }
+    return h;
+}
+
+bool NodeId::operator==(const NodeId& other) const {
+    if (ns != other.ns || idType != other.idType) return false;
+    switch (idType) {
+        case NodeIdType::Numeric: return numericId == other.numericId;
+        case NodeIdType::String: return stringId == other.stringId;
+        case NodeIdType::Guid: return memcmp(&guidId, &other.guidId, sizeof(NodeGuid)) == 0;
+    }
+    return false;
+}
+
+bool NodeId::operator<(const NodeId& other) const {
+    if (ns != other.ns) return ns < other.ns;
+    if (idType != other.idType) return idType < other.idType;
+    switch (idType) {
+        case NodeIdType::Numeric: return numericId < other.numericId;
+        case NodeIdType::String: return stringId < other.stringId;
+        case NodeIdType::Guid: return memcmp(&guidId, &other.guidId, sizeof(NodeGuid)) < 0;
+    }
+    return false;
+}
@@ -3,6 +3,9 @@
 #include <string>
 #include <vector>
 #include <random>
+#include <future>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace std;
 
@@ -11,164 +14,845 @@ OPCUAClient::OPCUAClient() : connected(false), gen(rd()) {
     // Tags from Python example
     addTag("Voltage", "ns=2;i=2", "V", 190.0, 240.0);
     addTag("Current", "ns=2;i=3", "A", 1.0, 10.0);
-    addTag("Power", "ns=2;i=4", "W", 500.0, 2400.0);
+    addCalculatedTag("Power", "ns=2;i=4", "W", "Voltage * Current");
 }
 
 bool OPCUAClient::connect(const std::string& url) {
-    endpoint = url;
+    std::promise<bool> result;
+    std::future<bool> done = result.get_future();
+    
+    connectAsync(url, chrono::milliseconds(0), [&result](const AsyncResult<bool>& r) {
+        result.set_value(r.ok());
+    });
+    return done.get();
+}
+
+void OPCUAClient::disconnect() {
+    if (connected.exchange(false)) {
+        cout << "[OPC UA] Disconnecting..." << endl;
+    }
+}
+
+bool OPCUAClient::isConnected() const {
+    return connected;
+}
+
+template <typename T>
+std::shared_ptr<AsyncCall<T>> OPCUAClient::startCall(std::chrono::milliseconds timeout,
+                                                     typename AsyncCall<T>::Callback callback) {
+    auto call = std::make_shared<AsyncCall<T>>(loop, std::move(callback));
+    if (timeout.count() > 0) {
+        std::weak_ptr<AsyncCall<T>> weak = call;
+        call->setTimeoutTimer(loop.schedule(timeout, [weak]() {
+            if (auto c = weak.lock()) {
+                c->complete(AsyncStatus::TimedOut, T(), "timeout");
+            }
+        }));
+    }
+    return call;
+}
+
+AsyncHandle OPCUAClient::connectAsync(const std::string& url, std::chrono::milliseconds timeout,
+                                      AsyncCall<bool>::Callback callback) {
+    auto call = startCall<bool>(timeout, std::move(callback));
     cout << "[OPC UA] Connecting to " << url << "..." << endl;
     
-    this_thread::sleep_for(chrono::milliseconds(500));
+    // Задержка установки сессии - таймер цикла, а не sleep в потоке вызывающего
+    loop.schedule(connectLatency, [this, call, url]() {
+        if (call->done()) {
+            return;   // отменена или истёк таймаут
+        }
+        
+        endpoint = url;
+        if (url.find("localhost") != string::npos || url.find("4840") != string::npos) {
+            connected = true;
+            cout << "[OPC UA] Connected successfully!" << endl;
+            scheduleDrain();
+            call->complete(AsyncStatus::Completed, true);
+        } else {
+            connected = false;
+            cout << "[OPC UA] Simulation mode" << endl;
+            call->complete(AsyncStatus::Failed, false, "server not available");
+        }
+    });
+    return call;
+}
+
+AsyncHandle OPCUAClient::readAsync(const std::string& tagName, std::chrono::milliseconds timeout,
+                                   AsyncCall<TagData>::Callback callback) {
+    auto call = startCall<TagData>(timeout, std::move(callback));
+    loop.post([this, call, tagName]() {
+        if (call->done()) return;
+        
+        auto tag = getTagByName(tagName);
+        if (tag) {
+            call->complete(AsyncStatus::Completed, *tag);
+        } else {
+            call->complete(AsyncStatus::Failed, TagData(), "tag not found");
+        }
+    });
+    return call;
+}
+
+AsyncHandle OPCUAClient::writeAsync(const std::string& tagName, double value, std::chrono::milliseconds timeout,
+                                    AsyncCall<bool>::Callback callback) {
+    auto call = startCall<bool>(timeout, std::move(callback));
+    loop.post([this, call, tagName, value]() {
+        if (call->done()) return;
+        
+        if (writeTagByName(tagName, value)) {
+            call->complete(AsyncStatus::Completed, true);
+        } else {
+            call->complete(AsyncStatus::Failed, false, "write rejected");
+        }
+    });
+    return call;
+}
+
+AsyncHandle OPCUAClient::browseAsync(std::chrono::milliseconds timeout,
+                                     AsyncCall<std::vector<std::string>>::Callback callback) {
+    auto call = startCall<std::vector<std::string>>(timeout, std::move(callback));
+    loop.post([this, call]() {
+        if (call->done()) return;
+        
+        auto browse = [this](const std::vector<NodeId>& nodes,
+                             std::vector<std::vector<BrowseReference>>& results) {
+            return browseServer(nodes, results);
+        };
+        auto resolve = [this](const NodeId& id) {
+            size_t index = store.findByNodeId(id);
+            return index != TagStore::npos ? static_cast<uint32_t>(index) : AddressSpaceCache::npos;
+        };
+        if (addressCache.load(browse, resolve) == 0) {
+            call->complete(AsyncStatus::Failed, {}, "browse failed");
+            return;
+        }
+        
+        std::vector<std::string> names;
+        for (const auto& node : addressCache.variables()) {
+            names.emplace_back(node.tag != AddressSpaceCache::npos ? store.name(node.tag) : node.browseName);
+        }
+        call->complete(AsyncStatus::Completed, std::move(names));
+    });
+    return call;
+}
+
+bool OPCUAClient::browseServer(const std::vector<NodeId>& nodes,
+                               std::vector<std::vector<BrowseReference>>& results) const {
+    // Симуляция службы Browse: имена тегов с точками ("Line1.Pump.Speed")
+    // раскладываются по папкам ns=1;s=Line1, ns=1;s=Line1.Pump,
+    // переменные адресуются своими NodeId. Все узлы запроса - за один проход.
+    results.assign(nodes.size(), {});
     
-    if (url.find("localhost") != string::npos || url.find("4840") != string::npos) {
-        connected = true;
-        cout << "[OPC UA] Connected successfully!" << endl;
-        return true;
+    std::unordered_map<std::string_view, size_t> requested;
+    for (size_t k = 0; k < nodes.size(); k++) {
+        if (nodes[k] == AddressSpaceCache::objectsFolder()) {
+            requested.emplace(std::string_view(), k);
+        } else if (nodes[k].namespaceIndex() == 1 && nodes[k].type() == NodeIdType::String) {
+            requested.emplace(nodes[k].stringValue(), k);
+        }
     }
     
-    cout << "[OPC UA] Simulation mode" << endl;
-    connected = false;
-    return false;
+    std::unordered_set<std::string_view> folders;
+    size_t n = store.size();
+    for (size_t i = 0; i < n; i++) {
+        std::string_view name = store.name(i);
+        size_t start = 0;
+        for (;;) {
+            size_t dot = name.find('.', start);
+            std::string_view parent = start > 0 ? name.substr(0, start - 1) : std::string_view();
+            auto it = requested.find(parent);
+            
+            if (dot == std::string_view::npos) {
+                if (it != requested.end()) {
+                    results[it->second].push_back({store.node(i), std::string(name.substr(start)), NodeClass::Variable});
+                }
+                break;
+            }
+            
+            std::string_view folder = name.substr(0, dot);
+            if (it != requested.end() && folders.insert(folder).second) {
+                results[it->second].push_back({NodeId::string(1, folder),
+                                               std::string(name.substr(start, dot - start)), NodeClass::Object});
+            }
+            start = dot + 1;
+        }
+    }
+    return true;
 }
 
-void OPCUAClient::disconnect() {
+size_t OPCUAClient::resolveNode(const NodeId& nodeId) const {
+    uint32_t tag = addressCache.resolveTag(nodeId);
+    if (tag != AddressSpaceCache::npos) {
+        return tag;
+    }
+    return store.findByNodeId(nodeId);
+}
+
+OPCUAClient::ForwardState::ForwardState(size_t ringCapacity, const std::string& spillPath,
+                                        size_t drainBatch, size_t drainRate)
+    : buffer(ringCapacity, spillPath),
+      batch(drainBatch > 0 ? drainBatch : 1),
+      rate(drainRate > 0 ? drainRate : 1) {
+    // Пачка и её часть с отсчётами, плюс запас на выравнивание
+    arena.resize(2 * batch * sizeof(ForwardRecord) + 256);
+}
+
+void OPCUAClient::enableStoreAndForward(size_t ringCapacity, const std::string& spillPath,
+                                        size_t drainBatch, size_t drainRatePerSec) {
+    auto state = std::make_shared<ForwardState>(ringCapacity, spillPath, drainBatch, drainRatePerSec);
+    {
+        lock_guard<mutex> lock(pipeline_mutex);
+        forward = std::move(state);
+    }
+    cout << "[OPC UA] Store-and-forward enabled: " << ringCapacity
+         << " records in memory, spill to " << spillPath << endl;
     if (connected) {
-        cout << "[OPC UA] Disconnecting..." << endl;
-        connected = false;
+        scheduleDrain();
     }
 }
 
-bool OPCUAClient::isConnected() const {
-    return connected;
+void OPCUAClient::setForwardSink(std::function<void(const ForwardRecord*, size_t)> sink) {
+    lock_guard<mutex> lock(pipeline_mutex);
+    forwardSink = std::move(sink);
+}
+
+uint64_t OPCUAClient::pendingForwardCount() const {
+    lock_guard<mutex> lock(pipeline_mutex);
+    return forward ? forward->buffer.size() : 0;
+}
+
+bool OPCUAClient::startSharedMemoryFeed(const std::string& name, uint32_t capacity) {
+    // Прежняя лента закрывается до создания новой: иначе при том же имени
+    // новая область попала бы под запись и shm_unlink старого издателя
+    stopSharedMemoryFeed();
+    
+    if (capacity == 0) {
+        capacity = static_cast<uint32_t>(std::max<size_t>(store.size() * 2, 1024));
+    }
+    
+    auto feed = std::make_shared<SharedMemoryPublisher>();
+    if (!feed->open(name, capacity)) {
+        return false;
+    }
+    feed->publishAll(store);
+    std::atomic_store(&shmFeed, feed);
+    return true;
+}
+
+void OPCUAClient::stopSharedMemoryFeed() {
+    auto feed = std::atomic_exchange(&shmFeed, std::shared_ptr<SharedMemoryPublisher>());
+    if (!feed) {
+        return;
+    }
+    // Публикации, успевшие взять указатель, держат свои копии;
+    // закрываем ленту (и освобождаем имя), когда они закончат
+    while (feed.use_count() > 1) {
+        this_thread::yield();
+    }
+    feed->close();
+    cout << "[OPC UA] Shared memory feed stopped" << endl;
+}
+
+void OPCUAClient::scheduleDrain() {
+    {
+        lock_guard<mutex> lock(pipeline_mutex);
+        if (!forward) {
+            return;
+        }
+    }
+    if (drainScheduled.exchange(true)) {
+        return;
+    }
+    loop.schedule(chrono::milliseconds(100), [this]() {
+        drainScheduled = false;
+        drainForwardBuffer();
+    });
+}
+
+void OPCUAClient::drainForwardBuffer() {
+    // Выполняется в потоке цикла событий раз в 100 мс, пока есть что досылать
+    std::shared_ptr<ForwardState> state;
+    std::function<void(const ForwardRecord*, size_t)> sink;
+    {
+        lock_guard<mutex> lock(pipeline_mutex);
+        state = forward;
+        sink = forwardSink;
+    }
+    if (!connected || !state) {
+        return;
+    }
+    
+    size_t budget = std::min(state->batch, std::max<size_t>(state->rate / 10, 1));
+    
+    // Временные пачки живут в арене только на время такта
+    std::pmr::monotonic_buffer_resource arena(state->arena.data(), state->arena.size());
+    std::pmr::vector<ForwardRecord> batch(&arena);
+    batch.reserve(budget);
+    state->buffer.drain(budget, batch);
+    
+    // Записи оператора уходят на сервер в исходном порядке,
+    // собранные отсчёты - получателю истории
+    size_t writes = 0;
+    std::pmr::vector<ForwardRecord> samples(&arena);
+    samples.reserve(batch.size());
+    for (const auto& r : batch) {
+        if (r.kind == ForwardKind::Write) {
+            if (r.tag < store.size()) {
+                writeToServer(r.tag, r.value);
+                writes++;
+            }
+        } else {
+            samples.push_back(r);
+        }
+    }
+    
+    if (sink && !samples.empty()) {
+        sink(samples.data(), samples.size());
+    }
+    
+    if (!batch.empty()) {
+        cout << "[OPC UA] Forwarded " << writes << " writes, " << samples.size()
+             << " samples (" << state->buffer.size() << " pending)" << endl;
+    }
+    if (state->buffer.size() > 0) {
+        scheduleDrain();
+    }
 }
 
+void OPCUAClient::writeToServer(size_t index, double value) {
+    // Сессия симулируется: досланная запись на сервер - строка журнала
+    cout << "[OPC UA] Writing to server (forwarded): "
+         << store.name(index) << " = " << value << " " << store.unit(index) << endl;
+}
+
+namespace {
+
+int64_t nowMs() {
+    return chrono::duration_cast<chrono::milliseconds>(
+        chrono::system_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
 void OPCUAClient::addTag(const std::string& name, const std::string& nodeId, 
                 const std::string& unit, double minVal, double maxVal) {
-    lock_guard<mutex> lock(tags_mutex);
-    tags.emplace_back(name, nodeId, unit);
+    TagConfig cfg;
+    cfg.name = name;
+    cfg.nodeId = nodeId;
+    cfg.unit = unit;
+    cfg.minVal = minVal;
+    cfg.maxVal = maxVal;
+    
+    if (store.add(cfg) == TagStore::npos) {
+        cout << "[OPC UA] Error: Tag '" << name << "' already exists" << endl;
+        return;
+    }
     cout << "[OPC UA] Tag added: " << name << " [" << nodeId << "]" << endl;
 }
 
+size_t OPCUAClient::addTags(const std::vector<TagConfig>& configs) {
+    store.reserve(store.size() + configs.size());
+    
+    size_t added = 0;
+    size_t skipped = 0;
+    std::vector<std::pair<uint32_t, std::string>> formulas;
+    for (const auto& cfg : configs) {
+        size_t index = store.add(cfg);
+        if (index == TagStore::npos) {
+            skipped++;
+            continue;
+        }
+        added++;
+        if (!cfg.expression.empty()) {
+            formulas.emplace_back(static_cast<uint32_t>(index), cfg.expression);
+        }
+    }
+    
+    // Формулы компилируются после регистрации всех тегов:
+    // выражение может ссылаться на тег, объявленный ниже по файлу
+    size_t compiled = 0;
+    if (!formulas.empty()) {
+        lock_guard<mutex> lock(pipeline_mutex);
+        compiled = compileFormulasLocked(formulas);
+    }
+    
+    cout << "[OPC UA] Tags added: " << added;
+    if (!formulas.empty()) {
+        cout << " (" << compiled << " calculated)";
+    }
+    if (skipped > 0) {
+        cout << " (" << skipped << " duplicate names skipped)";
+    }
+    cout << endl;
+    return added;
+}
+
+bool OPCUAClient::addCalculatedTag(const std::string& name, const std::string& nodeId,
+                                   const std::string& unit, const std::string& expression) {
+    TagConfig cfg;
+    cfg.name = name;
+    cfg.nodeId = nodeId;
+    cfg.unit = unit;
+    cfg.expression = expression;
+    
+    size_t index = store.add(cfg);
+    if (index == TagStore::npos) {
+        cout << "[OPC UA] Error: Tag '" << name << "' already exists" << endl;
+        return false;
+    }
+    
+    {
+        lock_guard<mutex> lock(pipeline_mutex);
+        if (compileFormulasLocked({{static_cast<uint32_t>(index), expression}}) == 0) {
+            return false;
+        }
+    }
+    cout << "[OPC UA] Calculated tag added: " << name << " = " << expression << endl;
+    return true;
+}
+
+size_t OPCUAClient::compileFormulasLocked(const std::vector<std::pair<uint32_t, std::string>>& formulas) {
+    // Формула, ссылающаяся на ещё не скомпилированный вычисляемый тег,
+    // откладывается до следующего прохода. Если проход ничего не добавил,
+    // оставшиеся формулы образуют цикл. Ссылка на вычисляемый тег с
+    // ошибочной формулой (в этом или прошлом вызове) - отдельная ошибка.
+    std::vector<std::pair<uint32_t, std::string>> pending = formulas;
+    std::vector<std::pair<uint32_t, std::string>> next;
+    std::unordered_set<uint32_t> unresolved;
+    for (const auto& formula : formulas) {
+        unresolved.insert(formula.first);
+    }
+    size_t compiled = 0;
+    bool deferred = false;
+    std::string invalidDependency;
+    
+    auto resolve = [this, &deferred, &unresolved, &invalidDependency](std::string_view name) -> size_t {
+        size_t index = store.findByName(name);
+        if (index != TagStore::npos && store.isCalculated(index) &&
+            !calcEngine.isCalculated(static_cast<uint32_t>(index))) {
+            if (unresolved.count(static_cast<uint32_t>(index)) > 0) {
+                deferred = true;
+            } else if (invalidDependency.empty()) {
+                invalidDependency = name;
+            }
+            return TagStore::npos;
+        }
+        return index;
+    };
+    
+    auto fail = [this, &unresolved](uint32_t tag, const std::string& error) {
+        cout << "[OPC UA] Formula error in '" << store.name(tag) << "': " << error << endl;
+        store.set(tag, 0.0, 0, TagQuality::Bad, TAG_FLAG_CALCULATED);
+        unresolved.erase(tag);
+    };
+    
+    while (!pending.empty()) {
+        size_t before = compiled;
+        next.clear();
+        
+        for (const auto& formula : pending) {
+            std::string error;
+            deferred = false;
+            invalidDependency.clear();
+            if (calcEngine.addFormula(formula.first, formula.second, resolve, error)) {
+                compiled++;
+                unresolved.erase(formula.first);
+            } else if (!invalidDependency.empty()) {
+                fail(formula.first, "depends on invalid formula '" + invalidDependency + "'");
+            } else if (deferred) {
+                next.push_back(formula);
+            } else {
+                fail(formula.first, error);
+            }
+        }
+        
+        // Проход без продвижения: либо цикл, либо в этом проходе
+        // отказала формула, от которой зависят отложенные
+        if (compiled == before && next.size() == pending.size()) {
+            for (const auto& formula : next) {
+                fail(formula.first, "circular dependency");
+            }
+            break;
+        }
+        pending.swap(next);
+    }
+    
+    // Начальные значения вычисляемых тегов
+    if (compiled > 0) {
+        derivedSamples.clear();
+        calcEngine.evaluateAll(store, 0, derivedSamples);
+        for (const auto& s : derivedSamples) {
+            store.set(s.tag, s.value, store.timestamp(s.tag), s.quality, store.flagBits(s.tag));
+        }
+    }
+    return compiled;
+}
+
+size_t OPCUAClient::loadTagsFromFile(const std::string& path) {
+    auto start = chrono::steady_clock::now();
+    
+    std::vector<TagConfig> configs;
+    if (!TagConfigLoader::loadFile(path, configs)) {
+        return 0;
+    }
+    
+    size_t added = addTags(configs);
+    
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+    cout << "[OPC UA] Loaded " << path << " in " << elapsed.count() << " ms" << endl;
+    return added;
+}
+
 void OPCUAClient::updateValues() {
-    lock_guard<mutex> lock(tags_mutex);
+    lock_guard<mutex> lock(acquisition_mutex);
     
-    for (auto& tag : tags) {
-        // Если значение было записано вручную - не меняем его
-        if (tag.is_written) {
+    // Одна метка времени на весь цикл опроса
+    int64_t now = nowMs();
+    
+    cycleSamples.clear();
+    size_t n = store.size();
+    for (size_t i = 0; i < n; i++) {
+        // Записанные вручную и вычисляемые теги симуляция не трогает
+        if (store.isWritten(i) || store.isCalculated(i)) {
             continue;
         }
         
-        double minVal, maxVal;
+        // Тег опрашивается не чаще своего интервала. Допуск в 1/8 интервала
+        // гасит дрожание таймера вызывающего, иначе тег с интервалом, равным
+        // периоду таймера, пропускал бы каждый второй цикл
+        int interval = store.samplingInterval(i);
+        if (interval > 0) {
+            int64_t last = store.timestamp(i);
+            if (last != 0 && now - last < interval - interval / 8) {
+                continue;
+            }
+        }
+
+        uniform_real_distribution<double> dist(store.minValue(i), store.maxValue(i));
+        cycleSamples.push_back({static_cast<uint32_t>(i), now, dist(gen), TagQuality::Good});
+    }
+    
+    publishSamples(cycleSamples.data(), cycleSamples.size(), TAG_FLAG_NONE);
+}
+
+size_t OPCUAClient::applySamples(const TagSample* samples, size_t count, uint8_t flags) {
+    return publishSamples(samples, count, flags & TAG_FLAG_WRITTEN);
+}
+
+size_t OPCUAClient::publishSamples(const TagSample* samples, size_t count, uint8_t flags) {
+    // Записи оператора идут в обход фильтров: значение задано точно
+    if ((flags & TAG_FLAG_WRITTEN) == 0 && conditioningEnabled) {
+        lock_guard<mutex> lock(conditioning_mutex);
+        conditioner.process(samples, count, conditionedSamples);
         
-        if (tag.name == "Voltage") {
-            minVal = 190.0; maxVal = 240.0;
-        } else if (tag.name == "Current") {
-            minVal = 1.0; maxVal = 10.0;
-        } else if (tag.name == "Power") {
-            minVal = 500.0; maxVal = 2400.0;
-        } else {
-            minVal = 0.0; maxVal = 100.0;
+        size_t stored = storeSamples(conditionedSamples.data(), samples, count, flags);
+        lock_guard<mutex> pipelineLock(pipeline_mutex);
+        processSamplesLocked(conditionedSamples.data(), samples, count, flags);
+        return stored;
+    }
+    
+    // Живые значения публикуются сразу, каждый тег через свой seqlock:
+    // читатели и писатели других тегов здесь не ждут
+    size_t stored = storeSamples(samples, samples, count, flags);
+    
+    // Дальнейшие стадии хранят состояние между циклами и идут по очереди
+    lock_guard<mutex> lock(pipeline_mutex);
+    processSamplesLocked(samples, samples, count, flags);
+    return stored;
+}
+
+void OPCUAClient::processSamplesLocked(const TagSample* samples, const TagSample* rawSamples,
+                                       size_t count, uint8_t flags) {
+    // Пересчёт только зависимых вычисляемых тегов, в том же цикле
+    derivedSamples.clear();
+    calcEngine.evaluate(store, samples, count, derivedSamples);
+    storeSamples(derivedSamples.data(), derivedSamples.data(), derivedSamples.size(), TAG_FLAG_NONE);
+    
+    alarmEngine.process(samples, count);
+    alarmEngine.process(derivedSamples.data(), derivedSamples.size());
+    
+    // Без связи исходные отсчёты и записи копятся для досылки
+    if (forward && !connected) {
+        ForwardKind kind = (flags & TAG_FLAG_WRITTEN) ? ForwardKind::Write : ForwardKind::Sample;
+        forwardScratch.clear();
+        for (size_t k = 0; k < count; k++) {
+            const TagSample& s = rawSamples[k];
+            ForwardRecord r;
+            r.timestampMs = s.timestampMs;
+            r.value = s.value;
+            r.tag = s.tag;
+            r.kind = kind;
+            r.quality = static_cast<uint8_t>(s.quality);
+            forwardScratch.push_back(r);
+        }
+        forward->buffer.push(forwardScratch.data(), forwardScratch.size());
+    }
+    
+    // В трассу идут только исходные отсчёты и записи оператора: фильтры
+    // и вычисляемые теги при воспроизведении считаются заново
+    if (recorder) {
+        recorder->write(rawSamples, count, flags & TAG_FLAG_WRITTEN);
+    }
+}
+
+size_t OPCUAClient::storeSamples(const TagSample* samples, const TagSample* rawSamples,
+                                 size_t count, uint8_t flags) {
+    size_t n = store.size();
+    size_t stored = 0;
+    std::shared_ptr<SharedMemoryPublisher> feed = std::atomic_load(&shmFeed);
+    
+    // Один захват истории на пачку, а не на отсчёт: читатели истории
+    // ждут не дольше одной пачки, чтение живых значений не блокируется
+    lock_guard<mutex> lock(history_mutex);
+    for (size_t k = 0; k < count; k++) {
+        const TagSample& s = samples[k];
+        if (s.tag >= n) {
+            continue;
         }
         
-        uniform_real_distribution<double> dist(minVal, maxVal);
-        double newValue = dist(gen);
+        TagValue old;
+        if (flags & TAG_FLAG_WRITTEN) {
+            old = store.load(s.tag);
+            store.set(s.tag, s.value, s.timestampMs, s.quality, flags | (old.flags & TAG_FLAG_CALCULATED));
+        } else if (!store.setUnlessWritten(s.tag, s.value, s.timestampMs, s.quality, old)) {
+            // Между проверкой в цикле опроса и публикацией тег записали вручную
+            continue;
+        }
         
-        // Сохраняем в историю перед обновлением
-        addToHistory(tag.name, tag.value, tag.timestamp);
+        // Прежнее значение уходит в историю, у тегов с фильтрами -
+        // и прежний исходный отсчёт (записи оператора тоже)
+        historyLocked(s.tag).addValue(old.value, old.timestampMs);
+        if (s.tag < rawSeries.size() && rawSeries[s.tag].enabled) {
+            RawSeries& raw = rawSeries[s.tag];
+            raw.history.addValue(raw.lastValue, raw.lastTimestampMs);
+            raw.lastValue = rawSamples[k].value;
+            raw.lastTimestampMs = rawSamples[k].timestampMs;
+        }
         
-        tag.update(newValue, false);
+        if (feed) {
+            feed->publish(store, s.tag);
+        }
+        stored++;
+    }
+    return stored;
+}
+
+bool OPCUAClient::addFilter(const std::string& tagName, const FilterConfig& config) {
+    size_t index = store.findByName(tagName);
+    if (index == TagStore::npos) {
+        cout << "[OPC UA] Error: Tag '" << tagName << "' not found" << endl;
+        return false;
+    }
+    if (store.isCalculated(index)) {
+        cout << "[OPC UA] Error: Tag '" << tagName << "' is calculated and cannot be filtered" << endl;
+        return false;
+    }
+    
+    std::string error;
+    if (!conditioner.addFilter(static_cast<uint32_t>(index), config, error)) {
+        cout << "[OPC UA] Filter error for '" << tagName << "': " << error << endl;
+        return false;
+    }
+    
+    {
+        // До первого фильтра обработанный ряд и был исходным:
+        // исходная история начинается с копии текущей. Записи тегов
+        // без фильтров остаются пустыми и памяти под буфер не держат
+        lock_guard<mutex> lock(history_mutex);
+        while (rawSeries.size() <= index) {
+            rawSeries.emplace_back();
+        }
+        RawSeries& raw = rawSeries[index];
+        if (!raw.enabled) {
+            raw.history = historyLocked(index);
+            TagValue v = store.load(index);
+            raw.lastValue = v.value;
+            raw.lastTimestampMs = v.timestampMs;
+            raw.enabled = true;
+        }
+    }
+    conditioningEnabled = true;
+    cout << "[OPC UA] Filter added: " << tagName << " " << filterTypeToString(config.type) << endl;
+    return true;
+}
+
+size_t OPCUAClient::addAlarm(const std::string& tagName, AlarmType type, double limit,
+                             double deadband, int delayMs) {
+    size_t index = findTagIndex(tagName);
+    if (index == TagStore::npos) {
+        cout << "[OPC UA] Error: Tag '" << tagName << "' not found" << endl;
+        return TagStore::npos;
+    }
+    
+    AlarmRule rule;
+    rule.tag = static_cast<uint32_t>(index);
+    rule.type = type;
+    rule.limit = limit;
+    rule.deadband = deadband;
+    rule.delayMs = delayMs;
+    return alarmEngine.addRule(rule);
+}
+
+void OPCUAClient::setSimulationSeed(uint32_t seed) {
+    lock_guard<mutex> lock(acquisition_mutex);
+    gen.seed(seed);
+}
+
+bool OPCUAClient::startRecording(const std::string& path) {
+    lock_guard<mutex> lock(pipeline_mutex);
+    
+    std::vector<std::string> names;
+    size_t n = store.size();
+    names.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        names.emplace_back(store.name(i));
     }
+    
+    auto newRecorder = std::make_unique<SampleRecorder>();
+    if (!newRecorder->open(path, names)) {
+        return false;
+    }
+    recorder = std::move(newRecorder);
+    return true;
+}
+
+void OPCUAClient::stopRecording() {
+    lock_guard<mutex> lock(pipeline_mutex);
+    recorder.reset();
 }
 
 std::vector<OPCUAClient::TagData> OPCUAClient::readAllTags() {
     updateValues();
-    lock_guard<mutex> lock(tags_mutex);
-    return tags;
+    return getTags();
 }
 
 std::vector<OPCUAClient::TagData> OPCUAClient::getTags() const {
-    lock_guard<mutex> lock(tags_mutex);
-    return tags;
+    std::vector<TagData> result;
+    getTags(result);
+    return result;
 }
 
-bool OPCUAClient::writeTagByName(const std::string& tagName, double value) {
-    lock_guard<mutex> lock(tags_mutex);
+size_t OPCUAClient::readAllTags(std::vector<TagData>& out) {
+    updateValues();
+    return getTags(out);
+}
+
+size_t OPCUAClient::getTags(std::vector<TagData>& out) const {
+    size_t n = store.size();
+    out.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = makeTagData(i);
+    }
+    return n;
+}
+
+void OPCUAClient::snapshotValues(std::vector<double>& values, std::vector<int64_t>& timestamps,
+                                 std::vector<TagQuality>& qualities, std::vector<uint8_t>& flags) const {
+    store.snapshot(values, timestamps, qualities, flags);
+}
+
+OPCUAClient::TagData OPCUAClient::makeTagData(size_t index) const {
+    TagValue v = store.load(index);
     
-    for (auto& tag : tags) {
-        if (tag.name == tagName) {
-            // Сохраняем старое значение в историю
-            addToHistory(tagName, tag.value, tag.timestamp);
-            
-            // Обновляем текущее значение
-            written_values[tagName] = value;
-            tag.update(value, true);
-            
-            if (connected) {
-                cout << "[OPC UA] Writing to server: " 
-                      << tag.name << " = " << value << " " << tag.unit 
-                      << " (SAVED)" << endl;
-            } else {
-                cout << "[OPC UA] Simulation write: " 
-                      << tag.name << " = " << value << " " << tag.unit 
-                      << " (SAVED)" << endl;
-            }
-            return true;
-        }
+    TagData tag;
+    tag.name = store.name(index);
+    tag.nodeId = store.nodeId(index);
+    tag.value = v.value;
+    tag.unit = store.unit(index);
+    tag.timestampMs = v.timestampMs;
+    tag.quality = v.quality;
+    tag.is_written = (v.flags & TAG_FLAG_WRITTEN) != 0;
+    return tag;
+}
+
+bool OPCUAClient::writeTagByName(const std::string& tagName, double value) {
+    size_t index = store.findByName(tagName);
+    if (index == TagStore::npos) {
+        cout << "[OPC UA] Error: Tag '" << tagName << "' not found" << endl;
+        return false;
+    }
+    if (store.isCalculated(index)) {
+        cout << "[OPC UA] Error: Tag '" << tagName << "' is calculated and cannot be written" << endl;
+        return false;
     }
     
-    cout << "[OPC UA] Error: Tag '" << tagName << "' not found" << endl;
-    return false;
+    // Обновляем текущее значение (старое уходит в историю)
+    TagSample sample{static_cast<uint32_t>(index), nowMs(), value, TagQuality::Good};
+    publishSamples(&sample, 1, TAG_FLAG_WRITTEN);
+    
+    if (connected) {
+        cout << "[OPC UA] Writing to server: " 
+              << tagName << " = " << value << " " << store.unit(index) 
+              << " (SAVED)" << endl;
+    } else {
+        cout << "[OPC UA] Simulation write: " 
+              << tagName << " = " << value << " " << store.unit(index) 
+              << " (SAVED)" << endl;
+    }
+    return true;
 }
 
 bool OPCUAClient::writeTagById(const std::string& nodeId, double value) {
-    lock_guard<mutex> lock(tags_mutex);
-    
-    for (auto& tag : tags) {
-        if (tag.nodeId == nodeId) {
-            written_values[tag.name] = value;
-            tag.update(value, true);
-            
-            if (connected) {
-                cout << "[OPC UA] Writing to server (by ID): " 
-                      << tag.name << " [" << nodeId << "] = " 
-                      << value << " " << tag.unit << endl;
-            } else {
-                cout << "[OPC UA] Simulation write (by ID): " 
-                      << tag.name << " [" << nodeId << "] = " 
-                      << value << " " << tag.unit << endl;
-            }
-            return true;
-        }
+    return writeTagById(NodeId::fromText(nodeId), value);
+}
+
+bool OPCUAClient::writeTagById(const NodeId& nodeId, double value) {
+    size_t index = resolveNode(nodeId);
+    if (index == TagStore::npos) {
+        cout << "[OPC UA] Error: NodeId '" << nodeId.toString() << "' not found" << endl;
+        return false;
+    }
+    if (store.isCalculated(index)) {
+        cout << "[OPC UA] Error: NodeId '" << store.nodeId(index) << "' is calculated and cannot be written" << endl;
+        return false;
     }
     
-    cout << "[OPC UA] Error: NodeId '" << nodeId << "' not found" << endl;
-    return false;
+    TagSample sample{static_cast<uint32_t>(index), nowMs(), value, TagQuality::Good};
+    publishSamples(&sample, 1, TAG_FLAG_WRITTEN);
+    
+    if (connected) {
+        cout << "[OPC UA] Writing to server (by ID): " 
+              << store.name(index) << " [" << store.nodeId(index) << "] = " 
+              << value << " " << store.unit(index) << endl;
+    } else {
+        cout << "[OPC UA] Simulation write (by ID): " 
+              << store.name(index) << " [" << store.nodeId(index) << "] = " 
+              << value << " " << store.unit(index) << endl;
+    }
+    return true;
 }
 
 size_t OPCUAClient::tagCount() const {
-    lock_guard<mutex> lock(tags_mutex);
-    return tags.size();
+    return store.size();
 }
 
-OPCUAClient::TagData* OPCUAClient::getTagByName(const std::string& tagName) {
-    lock_guard<mutex> lock(tags_mutex);
-    for (auto& tag : tags) {
-        if (tag.name == tagName) {
-            return &tag;
-        }
+size_t OPCUAClient::findTagIndex(const std::string& tagName) const {
+    return store.findByName(tagName);
+}
+
+std::optional<OPCUAClient::TagData> OPCUAClient::getTagByName(const std::string& tagName) const {
+    size_t index = store.findByName(tagName);
+    if (index == TagStore::npos) {
+        return std::nullopt;
     }
-    return nullptr;
+    return makeTagData(index);
 }
 
 bool OPCUAClient::resetTagToAuto(const std::string& tagName) {
-    lock_guard<mutex> lock(tags_mutex);
-    
-    for (auto& tag : tags) {
-        if (tag.name == tagName && tag.is_written) {
-            tag.is_written = false;
-            cout << "[OPC UA] Tag reset to AUTO: " << tagName << endl;
-            return true;
+    size_t index = store.findByName(tagName);
+    if (index != TagStore::npos && store.isWritten(index)) {
+        store.setFlag(index, TAG_FLAG_WRITTEN, false);
+        {
+            // Сброс - часть потока: без него воспроизведённая запись
+            // держала бы тег в WRITTEN до конца трассы
+            lock_guard<mutex> lock(pipeline_mutex);
+            if (recorder) {
+                recorder->writeReset(static_cast<uint32_t>(index), nowMs());
+            }
         }
+        cout << "[OPC UA] Tag reset to AUTO: " << tagName << endl;
+        return true;
     }
     
     cout << "[OPC UA] Tag not found or not WRITTEN: " << tagName << endl;
@@ -178,20 +862,20 @@ bool OPCUAClient::resetTagToAuto(const std::string& tagName) {
 // ★★★★ МЕТОДЫ ДЛЯ ГРАФИКОВ ★★★★
 
 // Реализация методов TagData
-void OPCUAClient::TagData::update(double newValue, bool written) {
-    value = newValue;
-    is_written = written;
-    updateTimestamp();
-}
-
-void OPCUAClient::TagData::updateTimestamp() {
-    auto now = chrono::system_clock::now();
-    auto time = chrono::system_clock::to_time_t(now);
+std::string OPCUAClient::TagData::timestamp() const {
+    if (timestampMs == 0) {
+        return std::string();
+    }
+    time_t time = static_cast<time_t>(timestampMs / 1000);
     tm tm;
+#ifdef _WIN32
     localtime_s(&tm, &time);
-    char timeStr[100];
+#else
+    localtime_r(&time, &tm);
+#endif
+    char timeStr[16];
     strftime(timeStr, sizeof(timeStr), "%H:%M:%S", &tm);
-    timestamp = timeStr;
+    return timeStr;
 }
 
 void OPCUAClient::TagData::print() const {
@@ -199,41 +883,174 @@ void OPCUAClient::TagData::print() const {
           << setw(15) << name 
           << setw(10) << fixed << setprecision(2) << value 
           << setw(5) << unit 
-          << setw(25) << timestamp 
-          << setw(10) << quality 
+          << setw(25) << timestamp() 
+          << setw(10) << qualityString() 
           << (is_written ? " [WRITTEN]" : "")
           << endl;
 }
 
 // Реализация методов TagHistory
-void OPCUAClient::TagHistory::addValue(double value, const std::string& timestamp) {
-    values.push_back(value);
-    timestamps.push_back(timestamp);
+void OPCUAClient::TagHistory::addValue(double value, int64_t timestampMs) {
+    if (maxHistory == 0) {
+        return;
+    }
+    if (values.size() != maxHistory) {
+        setCapacity(maxHistory);
+    }
+    
+    // Кольцевой буфер: при переполнении затираем самый старый отсчёт
+    size_t pos = (head + count) % maxHistory;
+    values[pos] = value;
+    timestamps[pos] = timestampMs;
     
-    // Ограничиваем размер истории
-    if (values.size() > maxHistory) {
-        values.erase(values.begin());
-        timestamps.erase(timestamps.begin());
+    if (count < maxHistory) {
+        count++;
+    } else {
+        head = (head + 1) % maxHistory;
     }
+    total++;
 }
 
 void OPCUAClient::TagHistory::clear() {
-    values.clear();
-    timestamps.clear();
+    head = 0;
+    count = 0;
+}
+
+void OPCUAClient::TagHistory::setCapacity(size_t capacity) {
+    // Переупаковываем в хронологическом порядке, оставляя самые новые отсчёты
+    size_t keep = std::min(count, capacity);
+    std::vector<double> newValues(capacity);
+    std::vector<int64_t> newTimestamps(capacity);
+    read(total - keep, keep, newValues.data(), newTimestamps.data());
+    
+    values.swap(newValues);
+    timestamps.swap(newTimestamps);
+    maxHistory = capacity;
+    head = 0;
+    count = keep;
+}
+
+size_t OPCUAClient::TagHistory::read(uint64_t seq, size_t maxCount, double* outValues, int64_t* outTimestamps) const {
+    if (seq < firstSeq()) seq = firstSeq();
+    if (seq >= total) return 0;
+    
+    size_t n = std::min<uint64_t>(maxCount, total - seq);
+    size_t start = (head + static_cast<size_t>(seq - firstSeq())) % values.size();
+    
+    // Не более двух непрерывных участков кольца
+    size_t first = std::min(n, values.size() - start);
+    std::copy(values.begin() + start, values.begin() + start + first, outValues);
+    std::copy(timestamps.begin() + start, timestamps.begin() + start + first, outTimestamps);
+    std::copy(values.begin(), values.begin() + (n - first), outValues + first);
+    std::copy(timestamps.begin(), timestamps.begin() + (n - first), outTimestamps + first);
+    return n;
+}
+
+void OPCUAClient::TagHistory::copyValues(std::vector<double>& out) const {
+    out.resize(count);
+    if (count == 0) return;
+    size_t first = std::min(count, values.size() - head);
+    std::copy(values.begin() + head, values.begin() + head + first, out.begin());
+    std::copy(values.begin(), values.begin() + (count - first), out.begin() + first);
+}
+
+OPCUAClient::TagHistory* OPCUAClient::findHistoryLocked(const std::string& tagName) {
+    size_t index = store.findByName(tagName);
+    if (index == TagStore::npos || index >= tagHistories.size()) {
+        return nullptr;
+    }
+    return &tagHistories[index];
+}
+
+OPCUAClient::TagHistory& OPCUAClient::historyLocked(size_t index) {
+    // История создаётся при первом отсчёте тега; deque не перемещает
+    // уже созданные буферы, так что указатели getTagHistory остаются валидными
+    while (tagHistories.size() <= index) {
+        tagHistories.emplace_back();
+        tagHistories.back().setCapacity(historyCapacity);
+    }
+    return tagHistories[index];
 }
 
 // Получить историю тега
 OPCUAClient::TagHistory* OPCUAClient::getTagHistory(const std::string& tagName) {
     lock_guard<mutex> lock(history_mutex);
-    auto it = tagHistories.find(tagName);
-    if (it != tagHistories.end()) {
-        return &it->second;
-    }
-    return nullptr;
+    return findHistoryLocked(tagName);
 }
 
 // Добавить значение в историю
-void OPCUAClient::addToHistory(const std::string& tagName, double value, const std::string& timestamp) {
+void OPCUAClient::addToHistory(const std::string& tagName, double value, int64_t timestampMs) {
+    size_t index = store.findByName(tagName);
+    if (index == TagStore::npos) {
+        return;
+    }
+    lock_guard<mutex> lock(history_mutex);
+    historyLocked(index).addValue(value, timestampMs);
+}
+
+void OPCUAClient::setHistoryCapacity(size_t capacity) {
     lock_guard<mutex> lock(history_mutex);
-    tagHistories[tagName].addValue(value, timestamp);
-}
\ No newline at end of file
+    historyCapacity = capacity;
+    for (auto& history : tagHistories) {
+        history.setCapacity(capacity);
+    }
+    for (auto& raw : rawSeries) {
+        if (raw.enabled) {
+            raw.history.setCapacity(capacity);
+        }
+    }
+}
+
+bool OPCUAClient::getHistoryValues(const std::string& tagName, std::vector<double>& out) {
+    lock_guard<mutex> lock(history_mutex);
+    TagHistory* history = findHistoryLocked(tagName);
+    if (!history) {
+        out.clear();
+        return false;
+    }
+    history->copyValues(out);
+    return true;
+}
+
+bool OPCUAClient::getRawHistoryValues(const std::string& tagName, std::vector<double>& out) {
+    size_t index = store.findByName(tagName);
+    lock_guard<mutex> lock(history_mutex);
+    if (index == TagStore::npos || index >= rawSeries.size() || !rawSeries[index].enabled) {
+        out.clear();
+        return false;
+    }
+    rawSeries[index].history.copyValues(out);
+    return true;
+}
+
+size_t OPCUAClient::readHistory(const std::string& tagName, uint64_t& seq, uint64_t endSeq,
+                                size_t maxCount, double* outValues, int64_t* outTimestamps) {
+    lock_guard<mutex> lock(history_mutex);
+    const TagHistory* history = findHistoryLocked(tagName);
+    if (!history) {
+        return 0;
+    }
+    
+    if (seq < history->firstSeq()) {
+        seq = history->firstSeq();
+    }
+    if (seq >= endSeq) {
+        return 0;
+    }
+    
+    size_t n = history->read(seq, std::min<uint64_t>(maxCount, endSeq - seq), outValues, outTimestamps);
+    seq += n;
+    return n;
+}
+
+bool OPCUAClient::getHistoryRange(const std::string& tagName, uint64_t& firstSeq, uint64_t& endSeq) {
+    lock_guard<mutex> lock(history_mutex);
+    const TagHistory* history = findHistoryLocked(tagName);
+    if (!history) {
+        firstSeq = endSeq = 0;
+        return false;
+    }
+    firstSeq = history->firstSeq();
+    endSeq = history->total;
+    return true;
+}
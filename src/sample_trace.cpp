@@ -0,0 +1,233 @@
+#include "../include/sample_trace.hpp"
+#include "../include/opcua_client.hpp"
+#include <iostream>
+#include <cstring>
+#include <chrono>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+const char kTraceMagic[8] = {'O', 'P', 'C', 'T', 'R', 'A', 'C', 'E'};
+const uint32_t kTraceVersion = 2;
+const size_t kRecordBufferSize = 4096;   // записей в буфере записи/чтения
+
+}  // namespace
+
+// ---------------- SampleRecorder ----------------
+
+SampleRecorder::~SampleRecorder() {
+    close();
+}
+
+bool SampleRecorder::open(const std::string& path, const std::vector<std::string>& tagNames) {
+    close();
+
+    file.open(path, ios::binary | ios::trunc);
+    if (!file) {
+        cout << "[OPC UA] Trace error: cannot create " << path << endl;
+        return false;
+    }
+
+    tagCount = static_cast<uint32_t>(tagNames.size());
+    recorded = 0;
+    buffer.reserve(kRecordBufferSize);
+
+    file.write(kTraceMagic, sizeof(kTraceMagic));
+    file.write(reinterpret_cast<const char*>(&kTraceVersion), sizeof(kTraceVersion));
+    file.write(reinterpret_cast<const char*>(&tagCount), sizeof(tagCount));
+    for (const auto& name : tagNames) {
+        uint16_t len = static_cast<uint16_t>(name.size());
+        file.write(reinterpret_cast<const char*>(&len), sizeof(len));
+        file.write(name.data(), len);
+    }
+
+    cout << "[OPC UA] Recording " << tagCount << " tags to " << path << endl;
+    return true;
+}
+
+void SampleRecorder::write(const TagSample* samples, size_t count, uint8_t flags) {
+    if (!file.is_open()) return;
+
+    for (size_t i = 0; i < count; i++) {
+        const TagSample& s = samples[i];
+        if (s.tag >= tagCount) continue;
+
+        buffer.push_back({s.timestampMs, s.value, s.tag, static_cast<uint8_t>(s.quality), flags, 0});
+        if (buffer.size() == kRecordBufferSize) {
+            flush();
+        }
+    }
+}
+
+void SampleRecorder::writeReset(uint32_t tag, int64_t timestampMs) {
+    if (!file.is_open() || tag >= tagCount) return;
+
+    buffer.push_back({timestampMs, 0.0, tag, 0, TRACE_FLAG_RESET, 0});
+    if (buffer.size() == kRecordBufferSize) {
+        flush();
+    }
+}
+
+void SampleRecorder::flush() {
+    if (buffer.empty()) return;
+    file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(TraceRecord));
+    recorded += buffer.size();
+    buffer.clear();
+}
+
+void SampleRecorder::close() {
+    if (!file.is_open()) return;
+    flush();
+    file.close();
+    cout << "[OPC UA] Recording stopped: " << recorded << " samples" << endl;
+}
+
+// ---------------- TraceReplayer ----------------
+
+bool TraceReplayer::open(const std::string& tracePath) {
+    path = tracePath;
+    tagNames.clear();
+    if (file.is_open()) file.close();
+
+    file.open(path, ios::binary);
+    if (!file) {
+        cout << "[OPC UA] Trace error: cannot open " << path << endl;
+        return false;
+    }
+
+    char magic[8];
+    uint32_t count = 0;
+    version = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&count), sizeof(count));
+
+    if (!file || memcmp(magic, kTraceMagic, sizeof(magic)) != 0 || (version != 1 && version != kTraceVersion)) {
+        cout << "[OPC UA] Trace error: " << path << " is not a trace file" << endl;
+        file.close();
+        return false;
+    }
+
+    tagNames.resize(count);
+    for (auto& name : tagNames) {
+        uint16_t len = 0;
+        file.read(reinterpret_cast<char*>(&len), sizeof(len));
+        name.resize(len);
+        file.read(&name[0], len);
+    }
+
+    if (!file) {
+        cout << "[OPC UA] Trace error: " << path << " has a truncated tag directory" << endl;
+        file.close();
+        return false;
+    }
+
+    dataStart = file.tellg();
+    return true;
+}
+
+uint64_t TraceReplayer::replay(OPCUAClient& client, double speed) {
+    if (!file.is_open()) return 0;
+
+    // Каждый вызов воспроизводит трассу с начала
+    file.clear();
+    file.seekg(dataStart);
+
+    // Индексы тегов трассы -> индексы тегов клиента
+    std::vector<uint32_t> mapping(tagNames.size());
+    size_t missing = 0;
+    for (size_t i = 0; i < tagNames.size(); i++) {
+        size_t index = client.findTagIndex(tagNames[i]);
+        mapping[i] = static_cast<uint32_t>(index);
+        if (index == TagStore::npos) missing++;
+    }
+    if (missing > 0) {
+        cout << "[OPC UA] Replay: " << missing << " trace tags are unknown to the client, skipped" << endl;
+    }
+
+    cout << "[OPC UA] Replaying " << path << " at ";
+    if (speed > 0) {
+        cout << speed << "x" << endl;
+    } else {
+        cout << "max speed" << endl;
+    }
+
+    std::vector<TraceRecord> records(kRecordBufferSize);
+    std::vector<TagSample> batch;
+    batch.reserve(kRecordBufferSize);
+
+    auto wallStart = chrono::steady_clock::now();
+    int64_t traceStart = 0;
+    int64_t batchTime = 0;
+    uint8_t batchFlags = TAG_FLAG_NONE;
+    bool started = false;
+    uint64_t replayed = 0;
+
+    auto waitUntil = [&](int64_t timestampMs) {
+        if (speed > 0) {
+            auto offset = chrono::duration<double, milli>((timestampMs - traceStart) / speed);
+            this_thread::sleep_until(wallStart + chrono::duration_cast<chrono::steady_clock::duration>(offset));
+        }
+    };
+
+    // Отсчёты с одной меткой времени и одного вида уходят в клиент одной пачкой
+    auto submit = [&]() {
+        if (batch.empty()) return;
+        waitUntil(batchTime);
+        replayed += client.applySamples(batch.data(), batch.size(), batchFlags);
+        batch.clear();
+    };
+
+    for (;;) {
+        file.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(TraceRecord));
+        size_t got = static_cast<size_t>(file.gcount()) / sizeof(TraceRecord);
+        if (got == 0) break;
+
+        for (size_t i = 0; i < got; i++) {
+            const TraceRecord& r = records[i];
+            if (r.tag >= mapping.size() || mapping[r.tag] == static_cast<uint32_t>(TagStore::npos)) {
+                continue;
+            }
+
+            uint8_t quality = r.quality;
+            uint8_t flags = r.flags & TAG_FLAG_WRITTEN;
+            if (version == 1) {
+                // Качество занимало все 4 байта, флагов не было
+                uint32_t wide = 0;
+                memcpy(&wide, &r.quality, sizeof(wide));
+                quality = static_cast<uint8_t>(wide);
+                flags = TAG_FLAG_NONE;
+            }
+
+            if (!started) {
+                traceStart = r.timestampMs;
+                started = true;
+            }
+            if (version != 1 && (r.flags & TRACE_FLAG_RESET)) {
+                // Сброс применяется строго после предшествующих ему отсчётов
+                submit();
+                waitUntil(r.timestampMs);
+                client.resetTagToAuto(tagNames[r.tag]);
+                continue;
+            }
+
+            if (batch.empty()) {
+                batchTime = r.timestampMs;
+                batchFlags = flags;
+            } else if (r.timestampMs != batchTime || flags != batchFlags) {
+                submit();
+                batchTime = r.timestampMs;
+                batchFlags = flags;
+            }
+
+            batch.push_back({mapping[r.tag], r.timestampMs, r.value, static_cast<TagQuality>(quality)});
+        }
+    }
+    submit();
+
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - wallStart);
+    cout << "[OPC UA] Replay finished: " << replayed << " samples in " << elapsed.count() << " ms" << endl;
+    return replayed;
+}
@@ -0,0 +1,369 @@
+#include "../include/shm_feed.hpp"
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+size_t alignUp(size_t v, size_t a) {
+    return (v + a - 1) / a * a;
+}
+
+void copyField(char* dst, size_t size, std::string_view src) {
+    size_t n = min(src.size(), size - 1);
+    memcpy(dst, src.data(), n);
+    dst[n] = '\0';
+}
+
+}  // namespace
+
+size_t shm_feed::regionSize(uint32_t capacity) {
+    size_t directory = alignUp(sizeof(Header), 64);
+    size_t slots = alignUp(directory + capacity * sizeof(TagEntry), 64);
+    return slots + capacity * sizeof(TagSlot);
+}
+
+// ---------------- SharedRegion ----------------
+
+SharedRegion::~SharedRegion() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool SharedRegion::create(const std::string& name, size_t size) {
+    close();
+    uint64_t size64 = size;
+    HANDLE h = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                  static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64),
+                                  ("Local\\" + name).c_str());
+    if (h == nullptr) {
+        cout << "[OPC UA] Shared memory: CreateFileMapping failed for " << name << endl;
+        return false;
+    }
+    // Чужую (или ещё открытую читателями) область не переиспользуем:
+    // её размер и раскладка могут отличаться от новой
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        CloseHandle(h);
+        cout << "[OPC UA] Shared memory: " << name << " is already in use" << endl;
+        return false;
+    }
+    base = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (base == nullptr) {
+        CloseHandle(h);
+        cout << "[OPC UA] Shared memory: MapViewOfFile failed for " << name << endl;
+        return false;
+    }
+    mapping = h;
+    length = size;
+    regionName = name;
+    owner = true;
+    return true;
+}
+
+bool SharedRegion::open(const std::string& name) {
+    close();
+    // Отображение на запись: 64-битные атомарные чтения в 32-битной
+    // сборке делаются через cmpxchg8b и требуют доступной на запись страницы
+    HANDLE h = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, ("Local\\" + name).c_str());
+    if (h == nullptr) {
+        return false;
+    }
+    base = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (base == nullptr) {
+        CloseHandle(h);
+        return false;
+    }
+    MEMORY_BASIC_INFORMATION info;
+    VirtualQuery(base, &info, sizeof(info));
+    mapping = h;
+    length = info.RegionSize;
+    regionName = name;
+    owner = false;
+    return true;
+}
+
+void SharedRegion::close() {
+    if (base != nullptr) {
+        UnmapViewOfFile(base);
+        CloseHandle(mapping);
+    }
+    base = nullptr;
+    mapping = nullptr;
+    length = 0;
+}
+
+#else
+
+bool SharedRegion::create(const std::string& name, size_t size) {
+    close();
+    string path = "/" + name;
+    // O_EXCL: живую ленту другого издателя не затираем и не отвязываем
+    int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        if (errno == EEXIST) {
+            cout << "[OPC UA] Shared memory: " << path << " is already in use" << endl;
+        } else {
+            cout << "[OPC UA] Shared memory: shm_open failed for " << path << endl;
+        }
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ::close(fd);
+        shm_unlink(path.c_str());
+        cout << "[OPC UA] Shared memory: cannot size " << path << endl;
+        return false;
+    }
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        shm_unlink(path.c_str());
+        cout << "[OPC UA] Shared memory: mmap failed for " << path << endl;
+        return false;
+    }
+    base = p;
+    length = size;
+    regionName = name;
+    owner = true;
+    return true;
+}
+
+bool SharedRegion::open(const std::string& name) {
+    close();
+    string path = "/" + name;
+    // Отображение на запись: см. комментарий к версии для Windows
+    int fd = shm_open(path.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+    base = p;
+    length = static_cast<size_t>(st.st_size);
+    regionName = name;
+    owner = false;
+    return true;
+}
+
+void SharedRegion::close() {
+    if (base != nullptr) {
+        munmap(base, length);
+        if (owner) {
+            shm_unlink(("/" + regionName).c_str());
+        }
+    }
+    base = nullptr;
+    length = 0;
+}
+
+#endif
+
+// ---------------- SharedMemoryPublisher ----------------
+
+SharedMemoryPublisher::~SharedMemoryPublisher() {
+    close();
+}
+
+bool SharedMemoryPublisher::open(const std::string& name, uint32_t capacity) {
+    close();
+    if (!region.create(name, shm_feed::regionSize(capacity))) {
+        return false;
+    }
+
+    char* base = static_cast<char*>(region.data());
+    memset(base, 0, region.size());
+
+    header = new (base) shm_feed::Header();
+    header->version = shm_feed::kVersion;
+    header->capacity = capacity;
+    header->directoryOffset = static_cast<uint32_t>(alignUp(sizeof(shm_feed::Header), 64));
+    header->slotOffset = static_cast<uint32_t>(alignUp(header->directoryOffset + capacity * sizeof(shm_feed::TagEntry), 64));
+    header->tagCount.store(0, memory_order_relaxed);
+    header->publisherAlive.store(1, memory_order_relaxed);
+    header->updates.store(0, memory_order_relaxed);
+
+    directory = reinterpret_cast<shm_feed::TagEntry*>(base + header->directoryOffset);
+    slots = reinterpret_cast<shm_feed::TagSlot*>(base + header->slotOffset);
+    for (uint32_t i = 0; i < capacity; i++) {
+        new (&slots[i]) shm_feed::TagSlot();
+    }
+
+    // Сигнатура пишется последней: читатель не увидит недостроенную область
+    atomic_thread_fence(memory_order_release);
+    memcpy(header->magic, shm_feed::kMagic, sizeof(shm_feed::kMagic));
+
+    cout << "[OPC UA] Shared memory feed '" << name << "': " << capacity << " tags, "
+         << region.size() / 1024 << " KB" << endl;
+    return true;
+}
+
+void SharedMemoryPublisher::close() {
+    if (header != nullptr) {
+        header->publisherAlive.store(0, memory_order_release);
+    }
+    header = nullptr;
+    directory = nullptr;
+    slots = nullptr;
+    region.close();
+}
+
+void SharedMemoryPublisher::syncDirectory(const TagStore& store) {
+    lock_guard<mutex> lock(directory_mutex);
+
+    uint32_t published = header->tagCount.load(memory_order_relaxed);
+    size_t n = min<size_t>(store.size(), header->capacity);
+    for (size_t i = published; i < n; i++) {
+        shm_feed::TagEntry& e = directory[i];
+        copyField(e.name, sizeof(e.name), store.name(i));
+        copyField(e.nodeId, sizeof(e.nodeId), store.nodeId(i));
+        copyField(e.unit, sizeof(e.unit), store.unit(i));
+        e.minValue = store.minValue(i);
+        e.maxValue = store.maxValue(i);
+    }
+    if (n > published) {
+        header->tagCount.store(static_cast<uint32_t>(n), memory_order_release);
+    }
+}
+
+void SharedMemoryPublisher::publish(const TagStore& store, size_t index) {
+    if (index >= header->capacity) {
+        return;
+    }
+    if (index >= header->tagCount.load(memory_order_acquire)) {
+        syncDirectory(store);
+    }
+
+    shm_feed::TagSlot& s = slots[index];
+
+    // Писатели одного тега упорядочиваются на seq; кто захватил слот
+    // последним, тот и переносит самое свежее состояние из хранилища
+    uint32_t seq = s.seq.load(memory_order_relaxed);
+    for (;;) {
+        if (seq & 1) {
+            this_thread::yield();
+            seq = s.seq.load(memory_order_relaxed);
+            continue;
+        }
+        if (s.seq.compare_exchange_weak(seq, seq + 1, memory_order_acquire, memory_order_relaxed)) {
+            break;
+        }
+    }
+    atomic_thread_fence(memory_order_release);
+
+    TagValue v = store.load(index);
+    s.value.store(v.value, memory_order_relaxed);
+    s.timestampMs.store(v.timestampMs, memory_order_relaxed);
+    s.quality.store(static_cast<uint8_t>(v.quality), memory_order_relaxed);
+    s.flags.store(v.flags, memory_order_relaxed);
+
+    s.seq.store(seq + 2, memory_order_release);
+    header->updates.fetch_add(1, memory_order_relaxed);
+}
+
+void SharedMemoryPublisher::publishAll(const TagStore& store) {
+    syncDirectory(store);
+    size_t n = min<size_t>(store.size(), header->capacity);
+    for (size_t i = 0; i < n; i++) {
+        publish(store, i);
+    }
+}
+
+// ---------------- SharedMemoryReader ----------------
+
+bool SharedMemoryReader::open(const std::string& name) {
+    close();
+    if (!region.open(name)) {
+        return false;
+    }
+
+    const char* base = static_cast<const char*>(region.data());
+    const shm_feed::Header* h = reinterpret_cast<const shm_feed::Header*>(base);
+    if (region.size() < sizeof(shm_feed::Header) ||
+        memcmp(h->magic, shm_feed::kMagic, sizeof(shm_feed::kMagic)) != 0 ||
+        h->version != shm_feed::kVersion ||
+        region.size() < shm_feed::regionSize(h->capacity)) {
+        region.close();
+        return false;
+    }
+    atomic_thread_fence(memory_order_acquire);
+
+    header = h;
+    directory = reinterpret_cast<const shm_feed::TagEntry*>(base + h->directoryOffset);
+    slots = reinterpret_cast<const shm_feed::TagSlot*>(base + h->slotOffset);
+    return true;
+}
+
+void SharedMemoryReader::close() {
+    header = nullptr;
+    directory = nullptr;
+    slots = nullptr;
+    region.close();
+}
+
+size_t SharedMemoryReader::tagCount() const {
+    return header ? header->tagCount.load(memory_order_acquire) : 0;
+}
+
+size_t SharedMemoryReader::find(const std::string& name) const {
+    size_t n = tagCount();
+    for (size_t i = 0; i < n; i++) {
+        if (name == directory[i].name) return i;
+    }
+    return TagStore::npos;
+}
+
+bool SharedMemoryReader::publisherAlive() const {
+    return header && header->publisherAlive.load(memory_order_acquire) != 0;
+}
+
+bool SharedMemoryReader::read(size_t index, TagValue& out) const {
+    // Индекс вне опубликованного каталога (или закрытый канал)
+    if (index >= tagCount()) {
+        return false;
+    }
+    const shm_feed::TagSlot& s = slots[index];
+    for (uint32_t attempt = 0; attempt < kMaxReadAttempts; attempt++) {
+        uint32_t before = s.seq.load(memory_order_acquire);
+        if (before & 1) {
+            // Издатель, упавший посреди записи, оставит seq нечётным навсегда
+            if (!publisherAlive()) {
+                return false;
+            }
+            this_thread::yield();
+            continue;
+        }
+        TagValue v;
+        v.value = s.value.load(memory_order_relaxed);
+        v.timestampMs = s.timestampMs.load(memory_order_relaxed);
+        v.quality = static_cast<TagQuality>(s.quality.load(memory_order_relaxed));
+        v.flags = s.flags.load(memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+        if (s.seq.load(memory_order_relaxed) == before) {
+            out = v;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,253 @@
+#include "../include/signal_filter.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+const char* filterTypeToString(FilterType type) {
+    switch (type) {
+        case FilterType::Ema: return "EMA";
+        case FilterType::MovingAverage: return "MA";
+        case FilterType::Median: return "MEDIAN";
+        case FilterType::RateOfChange: return "ROC";
+        case FilterType::SpikeReject: return "SPIKE";
+    }
+    return "UNKNOWN";
+}
+
+bool SignalConditioner::addFilter(uint32_t tag, const FilterConfig& config, std::string& error) {
+    lock_guard<mutex> lock(filter_mutex);
+
+    uint32_t slot = 0;
+    switch (config.type) {
+        case FilterType::Ema:
+            if (!(config.alpha > 0.0 && config.alpha <= 1.0)) {
+                error = "alpha must be in (0, 1]";
+                return false;
+            }
+            slot = static_cast<uint32_t>(emaAlpha.size());
+            emaAlpha.push_back(config.alpha);
+            emaValue.push_back(0.0);
+            emaPrimed.push_back(0);
+            break;
+
+        case FilterType::MovingAverage:
+        case FilterType::Median:
+            if (config.window < 1 || config.window > kMaxWindow) {
+                error = "window must be 1.." + to_string(kMaxWindow);
+                return false;
+            }
+            if (config.type == FilterType::MovingAverage) {
+                slot = static_cast<uint32_t>(maWindow.size());
+                maWindow.push_back(config.window);
+                maOffset.push_back(static_cast<uint32_t>(maPool.size()));
+                maHead.push_back(0);
+                maCount.push_back(0);
+                maSum.push_back(0.0);
+                maPool.resize(maPool.size() + config.window, 0.0);
+            } else {
+                slot = static_cast<uint32_t>(medWindow.size());
+                medWindow.push_back(config.window);
+                medOffset.push_back(static_cast<uint32_t>(medRing.size()));
+                medHead.push_back(0);
+                medCount.push_back(0);
+                medRing.resize(medRing.size() + config.window, 0.0);
+                medSorted.resize(medSorted.size() + config.window, 0.0);
+            }
+            break;
+
+        case FilterType::RateOfChange:
+            slot = static_cast<uint32_t>(rocLast.size());
+            rocLast.push_back(0.0);
+            rocTime.push_back(0);
+            rocPrimed.push_back(0);
+            break;
+
+        case FilterType::SpikeReject:
+            if (!(config.maxStep > 0.0)) {
+                error = "maxStep must be positive";
+                return false;
+            }
+            slot = static_cast<uint32_t>(spikeMaxStep.size());
+            spikeMaxStep.push_back(config.maxStep);
+            spikeMaxRejects.push_back(config.maxRejects);
+            spikeLast.push_back(0.0);
+            spikeRejected.push_back(0);
+            spikePrimed.push_back(0);
+            break;
+
+        default:
+            error = "unknown filter type";
+            return false;
+    }
+
+    filterTag.push_back(tag);
+    filterType.push_back(config.type);
+    filterSlot.push_back(slot);
+    indexDirty = true;
+    return true;
+}
+
+size_t SignalConditioner::filterCount() {
+    lock_guard<mutex> lock(filter_mutex);
+    return filterTag.size();
+}
+
+bool SignalConditioner::hasFilters(uint32_t tag) {
+    lock_guard<mutex> lock(filter_mutex);
+    if (indexDirty) rebuildIndex();
+    return tag + 1 < tagFilterStart.size() && tagFilterStart[tag + 1] > tagFilterStart[tag];
+}
+
+void SignalConditioner::rebuildIndex() {
+    uint32_t maxTag = 0;
+    for (uint32_t tag : filterTag) {
+        if (tag + 1 > maxTag) maxTag = tag + 1;
+    }
+
+    tagFilterStart.assign(maxTag + 1, 0);
+    for (uint32_t tag : filterTag) {
+        tagFilterStart[tag + 1]++;
+    }
+    maxChain = 0;
+    for (size_t t = 1; t < tagFilterStart.size(); t++) {
+        maxChain = max<size_t>(maxChain, tagFilterStart[t]);
+        tagFilterStart[t] += tagFilterStart[t - 1];
+    }
+
+    // Заполнение по порядку добавления сохраняет порядок цепочки
+    tagFilters.resize(filterTag.size());
+    std::vector<uint32_t> fill(tagFilterStart.begin(), tagFilterStart.end() - 1);
+    for (size_t f = 0; f < filterTag.size(); f++) {
+        tagFilters[fill[filterTag[f]]++] = static_cast<uint32_t>(f);
+    }
+
+    indexDirty = false;
+}
+
+void SignalConditioner::process(const TagSample* samples, size_t count, std::vector<TagSample>& out) {
+    lock_guard<mutex> lock(filter_mutex);
+
+    out.assign(samples, samples + count);
+    if (filterTag.empty()) return;
+    if (indexDirty) rebuildIndex();
+
+    const size_t tagLimit = tagFilterStart.size() - 1;
+
+    for (size_t stage = 0; stage < maxChain; stage++) {
+        // Раскладываем фильтры этой ступени по типам
+        for (auto& list : work) list.clear();
+        for (size_t k = 0; k < count; k++) {
+            uint32_t tag = out[k].tag;
+            if (tag >= tagLimit || out[k].quality == TagQuality::Bad || !isfinite(out[k].value)) continue;
+            uint32_t first = tagFilterStart[tag];
+            if (first + stage >= tagFilterStart[tag + 1]) continue;
+
+            uint32_t f = tagFilters[first + stage];
+            work[static_cast<size_t>(filterType[f])].push_back({filterSlot[f], static_cast<uint32_t>(k)});
+        }
+
+        TagSample* data = out.data();
+        runEma(data);
+        runMovingAverage(data);
+        runMedian(data);
+        runRateOfChange(data);
+        runSpikeReject(data);
+    }
+}
+
+void SignalConditioner::runEma(TagSample* out) {
+    for (const WorkItem& w : work[static_cast<size_t>(FilterType::Ema)]) {
+        double x = out[w.sample].value;
+        double v = emaPrimed[w.filter] ? emaValue[w.filter] + emaAlpha[w.filter] * (x - emaValue[w.filter]) : x;
+        emaValue[w.filter] = v;
+        emaPrimed[w.filter] = 1;
+        out[w.sample].value = v;
+    }
+}
+
+void SignalConditioner::runMovingAverage(TagSample* out) {
+    for (const WorkItem& w : work[static_cast<size_t>(FilterType::MovingAverage)]) {
+        uint32_t f = w.filter;
+        double* ring = maPool.data() + maOffset[f];
+        double x = out[w.sample].value;
+
+        // Текущая сумма: вычитаем вытесняемый отсчёт, добавляем новый
+        if (maCount[f] == maWindow[f]) {
+            maSum[f] -= ring[maHead[f]];
+        } else {
+            maCount[f]++;
+        }
+        ring[maHead[f]] = x;
+        maSum[f] += x;
+        maHead[f] = (maHead[f] + 1) % maWindow[f];
+
+        out[w.sample].value = maSum[f] / maCount[f];
+    }
+}
+
+void SignalConditioner::runMedian(TagSample* out) {
+    for (const WorkItem& w : work[static_cast<size_t>(FilterType::Median)]) {
+        uint32_t f = w.filter;
+        double* ring = medRing.data() + medOffset[f];
+        double* sorted = medSorted.data() + medOffset[f];
+        double x = out[w.sample].value;
+        uint32_t n = medCount[f];
+
+        // Окно не длиннее kMaxWindow: сдвиг отсортированного массива -
+        // ограниченная работа на отсчёт
+        if (n == medWindow[f]) {
+            double old = ring[medHead[f]];
+            double* pos = lower_bound(sorted, sorted + n, old);
+            copy(pos + 1, sorted + n, pos);
+            n--;
+        }
+        double* pos = upper_bound(sorted, sorted + n, x);
+        copy_backward(pos, sorted + n, sorted + n + 1);
+        *pos = x;
+        n++;
+
+        ring[medHead[f]] = x;
+        medHead[f] = (medHead[f] + 1) % medWindow[f];
+        medCount[f] = n;
+
+        out[w.sample].value = (n & 1) ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+    }
+}
+
+void SignalConditioner::runRateOfChange(TagSample* out) {
+    for (const WorkItem& w : work[static_cast<size_t>(FilterType::RateOfChange)]) {
+        uint32_t f = w.filter;
+        double x = out[w.sample].value;
+        int64_t t = out[w.sample].timestampMs;
+
+        double rate = 0.0;
+        if (rocPrimed[f] && t > rocTime[f]) {
+            rate = (x - rocLast[f]) * 1000.0 / static_cast<double>(t - rocTime[f]);
+        }
+        rocLast[f] = x;
+        rocTime[f] = t;
+        rocPrimed[f] = 1;
+        out[w.sample].value = rate;
+    }
+}
+
+void SignalConditioner::runSpikeReject(TagSample* out) {
+    for (const WorkItem& w : work[static_cast<size_t>(FilterType::SpikeReject)]) {
+        uint32_t f = w.filter;
+        double x = out[w.sample].value;
+
+        // Скачок больше maxStep заменяется последним принятым значением,
+        // пока выбросы не повторятся maxRejects раз подряд (тогда это ступенька)
+        if (spikePrimed[f] && fabs(x - spikeLast[f]) > spikeMaxStep[f] &&
+            spikeRejected[f] < spikeMaxRejects[f]) {
+            spikeRejected[f]++;
+            out[w.sample].value = spikeLast[f];
+            out[w.sample].quality = max(out[w.sample].quality, TagQuality::Uncertain);
+            continue;
+        }
+        spikeLast[f] = x;
+        spikeRejected[f] = 0;
+        spikePrimed[f] = 1;
+    }
+}
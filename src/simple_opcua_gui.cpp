@@ -12,6 +12,9 @@ void CreateGraphWindow(HWND hParent, const std::string& tagName, const std::stri
 OPCUAClient g_client;
 HWND g_hList = NULL;
 
+// Результат асинхронного подключения (wParam = 1 - подключено)
+#define WM_APP_CONNECTED (WM_APP + 1)
+
 // Простой диалог записи
 INT_PTR CALLBACK WriteDialogProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam) {
     switch (msg) {
@@ -31,7 +34,7 @@ INT_PTR CALLBACK WriteDialogProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lPar
             auto tags = g_client.getTags();
             
             for (const auto& tag : tags) {
-                SendMessage(hCombo, CB_ADDSTRING, 0, (LPARAM)tag.name.c_str());
+                SendMessage(hCombo, CB_ADDSTRING, 0, (LPARAM)tag.name.data());
             }
             
             if (!tags.empty()) {
@@ -142,12 +145,8 @@ INT_PTR CALLBACK ResetDialogProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lPar
                 int resetCount = 0;
                 
                 for (const auto& tag : tags) {
-                    if (tag.is_written) {
-                        auto tagPtr = g_client.getTagByName(tag.name);
-                        if (tagPtr) {
-                            tagPtr->is_written = false;  // Сбрасываем флаг
-                            resetCount++;
-                        }
+                    if (tag.is_written && g_client.resetTagToAuto(std::string(tag.name))) {
+                        resetCount++;
                     }
                 }
                 
@@ -195,7 +194,7 @@ void UpdateTagList() {
             lvi.stateMask = LVIS_SELECTED;
         }
         
-        lvi.pszText = (LPSTR)tags[i].name.c_str();
+        lvi.pszText = (LPSTR)tags[i].name.data();
         ListView_InsertItem(g_hList, &lvi);
         
         // Значение
@@ -204,7 +203,7 @@ void UpdateTagList() {
         ListView_SetItemText(g_hList, i, 1, valueStr);
         
         // Единицы измерения
-        ListView_SetItemText(g_hList, i, 2, (LPSTR)tags[i].unit.c_str());
+        ListView_SetItemText(g_hList, i, 2, (LPSTR)tags[i].unit.data());
         
         // Статус (WRITTEN или AUTO)
         char status[20];
@@ -212,10 +211,11 @@ void UpdateTagList() {
         ListView_SetItemText(g_hList, i, 3, status);
         
         // Время
-        ListView_SetItemText(g_hList, i, 4, (LPSTR)tags[i].timestamp.c_str());
+        std::string timeStr = tags[i].timestamp();
+        ListView_SetItemText(g_hList, i, 4, (LPSTR)timeStr.c_str());
         
         // Качество
-        ListView_SetItemText(g_hList, i, 5, (LPSTR)tags[i].quality.c_str());
+        ListView_SetItemText(g_hList, i, 5, (LPSTR)tags[i].qualityString());
     }
 }
 
@@ -287,8 +287,12 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             lvc.cx = 80;
             ListView_InsertColumn(g_hList, 5, &lvc);
             
-            // Автоподключение и обновление
-            g_client.connect("opc.tcp://localhost:4840");
+            // Автоподключение без блокировки окна: результат придёт сообщением
+            SetWindowText(hWnd, "OPC UA Monitor - Connecting...");
+            g_client.connectAsync("opc.tcp://localhost:4840", std::chrono::milliseconds(5000),
+                                  [hWnd](const AsyncResult<bool>& result) {
+                                      PostMessage(hWnd, WM_APP_CONNECTED, result.ok() ? 1 : 0, 0);
+                                  });
             UpdateTagList();
             
             break;
@@ -356,6 +360,12 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             break;
         }
         
+        case WM_APP_CONNECTED:
+            SetWindowText(hWnd, wParam ? "OPC UA Monitor - Connected"
+                                       : "OPC UA Monitor - Simulation mode");
+            UpdateTagList();
+            break;
+            
         case WM_TIMER: // Автообновление
             if (wParam == 1) {
                 g_client.updateValues();
@@ -384,6 +394,15 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
                    LPSTR lpCmdLine, int nCmdShow) {
+    // Файл конфигурации тегов (CSV/JSON) можно передать в командной строке
+    if (lpCmdLine && lpCmdLine[0] != '\0') {
+        std::string configPath = lpCmdLine;
+        if (configPath.size() >= 2 && configPath.front() == '"' && configPath.back() == '"') {
+            configPath = configPath.substr(1, configPath.size() - 2);
+        }
+        g_client.loadTagsFromFile(configPath);
+    }
+    
     WNDCLASS wc = {0};
     wc.lpfnWndProc = WndProc;
     wc.hInstance = hInstance;
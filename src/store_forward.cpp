@@ -0,0 +1,137 @@
+#include "../include/store_forward.hpp"
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+const size_t kSpillBufferRecords = 1024;
+
+}  // namespace
+
+StoreForwardBuffer::StoreForwardBuffer(size_t ringCapacity, const std::string& path, uint64_t maxSpill)
+    : ring(std::max<size_t>(ringCapacity, 1)), spillPath(path), maxSpillRecords(maxSpill) {
+    spillBuffer.reserve(kSpillBufferRecords);
+}
+
+StoreForwardBuffer::~StoreForwardBuffer() {
+    if (spill.is_open()) {
+        spill.close();
+    }
+}
+
+bool StoreForwardBuffer::openSpill() {
+    if (spill.is_open()) return true;
+    if (spillPath.empty()) return false;
+
+    spill.clear();
+    spill.open(spillPath, ios::in | ios::out | ios::binary | ios::trunc);
+    if (!spill) {
+        cout << "[OPC UA] Store-and-forward: cannot open spill file " << spillPath << endl;
+        return false;
+    }
+    spillWritten = 0;
+    spillRead = 0;
+    return true;
+}
+
+void StoreForwardBuffer::flushSpill() {
+    if (spillBuffer.empty()) return;
+    spill.seekp(static_cast<streamoff>(spillWritten * sizeof(ForwardRecord)));
+    spill.write(reinterpret_cast<const char*>(spillBuffer.data()), spillBuffer.size() * sizeof(ForwardRecord));
+    spillWritten += spillBuffer.size();
+    spillBuffer.clear();
+}
+
+void StoreForwardBuffer::push(const ForwardRecord* records, size_t n) {
+    lock_guard<mutex> lock(buffer_mutex);
+
+    for (size_t i = 0; i < n; i++) {
+        bool onDisk = spillWritten - spillRead + spillBuffer.size() > 0;
+
+        if (!onDisk && count < ring.size()) {
+            ring[(head + count) % ring.size()] = records[i];
+            count++;
+            continue;
+        }
+
+        // Кольцо заполнено (или диск уже используется) - пишем в сегмент
+        uint64_t onDiskCount = spillWritten - spillRead + spillBuffer.size();
+        if ((maxSpillRecords > 0 && onDiskCount >= maxSpillRecords) || !openSpill()) {
+            dropped++;
+            continue;
+        }
+
+        spillBuffer.push_back(records[i]);
+        if (spillBuffer.size() == kSpillBufferRecords) {
+            flushSpill();
+        }
+    }
+}
+
+void StoreForwardBuffer::refillFromSpill() {
+    flushSpill();
+
+    size_t room = ring.size() - count;
+    uint64_t available = spillWritten - spillRead;
+    size_t n = static_cast<size_t>(std::min<uint64_t>(room, available));
+    if (n == 0) return;
+
+    spill.seekg(static_cast<streamoff>(spillRead * sizeof(ForwardRecord)));
+    for (size_t i = 0; i < n; i++) {
+        spill.read(reinterpret_cast<char*>(&ring[(head + count) % ring.size()]), sizeof(ForwardRecord));
+        count++;
+    }
+    spillRead += n;
+
+    // Файл прочитан полностью - начинаем сегмент заново
+    if (spillRead == spillWritten) {
+        spill.close();
+        spillWritten = 0;
+        spillRead = 0;
+    }
+}
+
+size_t StoreForwardBuffer::drain(size_t maxCount, std::vector<ForwardRecord>& out) {
+    return drainInto(maxCount, out);
+}
+
+size_t StoreForwardBuffer::drain(size_t maxCount, std::pmr::vector<ForwardRecord>& out) {
+    return drainInto(maxCount, out);
+}
+
+template <typename Vector>
+size_t StoreForwardBuffer::drainInto(size_t maxCount, Vector& out) {
+    lock_guard<mutex> lock(buffer_mutex);
+
+    size_t n = 0;
+    while (n < maxCount) {
+        if (count == 0) {
+            if (spillWritten - spillRead + spillBuffer.size() == 0) break;
+            refillFromSpill();
+            if (count == 0) break;
+        }
+
+        out.push_back(ring[head]);
+        head = (head + 1) % ring.size();
+        count--;
+        n++;
+    }
+    return n;
+}
+
+uint64_t StoreForwardBuffer::size() const {
+    lock_guard<mutex> lock(buffer_mutex);
+    return count + (spillWritten - spillRead) + spillBuffer.size();
+}
+
+uint64_t StoreForwardBuffer::spilledCount() const {
+    lock_guard<mutex> lock(buffer_mutex);
+    return (spillWritten - spillRead) + spillBuffer.size();
+}
+
+uint64_t StoreForwardBuffer::droppedCount() const {
+    lock_guard<mutex> lock(buffer_mutex);
+    return dropped;
+}
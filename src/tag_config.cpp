@@ -0,0 +1,344 @@
+#include "../include/tag_config.hpp"
+#include <iostream>
+#include <fstream>
+#include <charconv>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+const size_t kChunkSize = 1 << 16;
+const size_t kConsumeError = static_cast<size_t>(-1);
+
+// Читает файл блоками и передаёт разборщику накопленные данные.
+// consume(data, size, eof) возвращает число байт, которые можно выбросить
+// (конец последней полностью разобранной записи), либо kConsumeError.
+template <typename Consumer>
+bool streamFile(const string& path, Consumer&& consume) {
+    ifstream file(path, ios::binary);
+    if (!file) {
+        cout << "[OPC UA] Config error: cannot open " << path << endl;
+        return false;
+    }
+
+    vector<char> buffer(kChunkSize);
+    size_t used = 0;
+
+    for (;;) {
+        // Запись длиннее блока - расширяем буфер
+        if (used == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+        }
+
+        file.read(buffer.data() + used, buffer.size() - used);
+        size_t got = static_cast<size_t>(file.gcount());
+        bool eof = got == 0;
+        used += got;
+
+        size_t consumed = consume(buffer.data(), used, eof);
+        if (consumed == kConsumeError) {
+            return false;
+        }
+
+        if (consumed > 0) {
+            memmove(buffer.data(), buffer.data() + consumed, used - consumed);
+            used -= consumed;
+        }
+
+        if (eof) {
+            return true;
+        }
+    }
+}
+
+const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+    return p;
+}
+
+bool parseDouble(const char* first, const char* last, double& out) {
+    first = skipSpaces(first, last);
+    while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')) --last;
+    if (first == last) return true;  // пустое поле - значение по умолчанию
+    if (*first == '+') ++first;
+    auto res = from_chars(first, last, out);
+    return res.ec == errc() && res.ptr == last;
+}
+
+bool parseInt(const char* first, const char* last, int& out) {
+    first = skipSpaces(first, last);
+    while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')) --last;
+    if (first == last) return true;
+    auto res = from_chars(first, last, out);
+    return res.ec == errc() && res.ptr == last;
+}
+
+// Диапазон и интервал, с которыми тег можно опрашивать:
+// uniform_real_distribution требует min <= max (NaN сюда не проходит)
+bool validLimits(const TagConfig& cfg) {
+    return cfg.minVal <= cfg.maxVal && cfg.samplingMs >= 0;
+}
+
+// ---------------- CSV ----------------
+
+// Читает одно поле CSV начиная с p, возвращает указатель за разделителем
+const char* readCsvField(const char* p, const char* end, string& out) {
+    out.clear();
+    p = skipSpaces(p, end);
+
+    if (p < end && *p == '"') {
+        ++p;
+        while (p < end) {
+            if (*p == '"') {
+                if (p + 1 < end && p[1] == '"') {
+                    out.push_back('"');
+                    p += 2;
+                    continue;
+                }
+                ++p;
+                break;
+            }
+            out.push_back(*p++);
+        }
+        while (p < end && *p != ',') ++p;
+    } else {
+        const char* start = p;
+        while (p < end && *p != ',') ++p;
+        const char* last = p;
+        while (last > start && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')) --last;
+        out.assign(start, last);
+    }
+
+    return p < end ? p + 1 : end;
+}
+
+// Границы поля без копирования (для числовых колонок)
+const char* csvFieldBounds(const char* p, const char* end, const char*& first, const char*& last) {
+    first = p;
+    while (p < end && *p != ',') ++p;
+    last = p;
+    return p < end ? p + 1 : end;
+}
+
+struct CsvParser {
+    vector<TagConfig>& out;
+    const string& path;
+    size_t lineNo = 0;
+
+    bool parseLine(const char* p, const char* end) {
+        ++lineNo;
+        const char* first = skipSpaces(p, end);
+        if (first == end || *first == '#') return true;  // пустая строка или комментарий
+
+        TagConfig cfg;
+        p = readCsvField(p, end, cfg.name);
+
+        // Строка заголовка
+        if (lineNo == 1 && (cfg.name == "name" || cfg.name == "Name")) return true;
+
+        p = readCsvField(p, end, cfg.nodeId);
+        p = readCsvField(p, end, cfg.unit);
+
+        const char* f;
+        const char* l;
+        p = csvFieldBounds(p, end, f, l);
+        bool ok = parseDouble(f, l, cfg.minVal);
+        p = csvFieldBounds(p, end, f, l);
+        ok = ok && parseDouble(f, l, cfg.maxVal);
+        p = csvFieldBounds(p, end, f, l);
+        ok = ok && parseInt(f, l, cfg.samplingMs);
+        readCsvField(p, end, cfg.expression);
+
+        if (!ok || cfg.name.empty() || cfg.nodeId.empty() || !validLimits(cfg)) {
+            cout << "[OPC UA] Config error: " << path << ":" << lineNo << ": invalid tag definition" << endl;
+            return false;
+        }
+
+        out.push_back(std::move(cfg));
+        return true;
+    }
+
+    size_t operator()(const char* data, size_t size, bool eof) {
+        const char* p = data;
+        const char* end = data + size;
+
+        for (;;) {
+            const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+            if (!nl) break;
+            if (!parseLine(p, nl)) return kConsumeError;
+            p = nl + 1;
+        }
+
+        // Последняя строка без перевода строки
+        if (eof && p < end) {
+            if (!parseLine(p, end)) return kConsumeError;
+            p = end;
+        }
+
+        return p - data;
+    }
+};
+
+// ---------------- JSON ----------------
+
+// Читает JSON-строку, p указывает на открывающую кавычку
+const char* readJsonString(const char* p, const char* end, string& out) {
+    out.clear();
+    ++p;
+    while (p < end && *p != '"') {
+        if (*p == '\\' && p + 1 < end) {
+            ++p;
+            switch (*p) {
+                case 'n': out.push_back('\n'); break;
+                case 't': out.push_back('\t'); break;
+                case 'r': out.push_back('\r'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'u': {
+                    unsigned code = 0;
+                    if (end - p > 4) {
+                        from_chars(p + 1, p + 5, code, 16);
+                        p += 4;
+                    }
+                    out.push_back(code < 0x80 ? static_cast<char>(code) : '?');
+                    break;
+                }
+                default: out.push_back(*p); break;
+            }
+            ++p;
+        } else {
+            out.push_back(*p++);
+        }
+    }
+    return p < end ? p + 1 : end;
+}
+
+struct JsonParser {
+    vector<TagConfig>& out;
+    const string& path;
+    size_t objectNo = 0;
+
+    // Разбор плоского объекта {"key": value, ...} между фигурными скобками
+    bool parseObject(const char* p, const char* end) {
+        ++objectNo;
+        TagConfig cfg;
+        string key;
+        string text;
+
+        ++p;  // '{'
+        while (p < end) {
+            while (p < end && *p != '"' && *p != '}') ++p;
+            if (p >= end || *p == '}') break;
+
+            p = readJsonString(p, end, key);
+            while (p < end && *p != ':') ++p;
+            if (p < end) ++p;
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) ++p;
+            if (p >= end) break;
+
+            if (*p == '"') {
+                p = readJsonString(p, end, text);
+                if (key == "name") cfg.name = text;
+                else if (key == "nodeId") cfg.nodeId = text;
+                else if (key == "unit") cfg.unit = text;
+                else if (key == "expression") cfg.expression = text;
+                continue;
+            }
+
+            const char* first = p;
+            while (p < end && *p != ',' && *p != '}' && *p != ' ' && *p != '\r' && *p != '\n') ++p;
+
+            bool ok = true;
+            if (key == "min") ok = parseDouble(first, p, cfg.minVal);
+            else if (key == "max") ok = parseDouble(first, p, cfg.maxVal);
+            else if (key == "samplingMs") ok = parseInt(first, p, cfg.samplingMs);
+
+            if (!ok) {
+                cout << "[OPC UA] Config error: " << path << ": tag #" << objectNo
+                     << ": invalid value for '" << key << "'" << endl;
+                return false;
+            }
+        }
+
+        if (cfg.name.empty() || cfg.nodeId.empty()) {
+            cout << "[OPC UA] Config error: " << path << ": tag #" << objectNo
+                 << ": name and nodeId are required" << endl;
+            return false;
+        }
+        if (!validLimits(cfg)) {
+            cout << "[OPC UA] Config error: " << path << ": tag #" << objectNo
+                 << ": invalid tag definition (min > max or negative samplingMs)" << endl;
+            return false;
+        }
+
+        out.push_back(std::move(cfg));
+        return true;
+    }
+
+    // Объект тега - это объект без вложенных объектов; внешние
+    // контейнеры ({"tags": [...]}, [...]) просто пропускаются.
+    size_t operator()(const char* data, size_t size, bool eof) {
+        const char* p = data;
+        const char* end = data + size;
+        const char* objStart = nullptr;
+        const char* safe = data;
+
+        while (p < end) {
+            char c = *p;
+            if (c == '"') {
+                // Строку пропускаем целиком, учитывая экранирование
+                const char* q = p + 1;
+                while (q < end && *q != '"') q += (*q == '\\') ? 2 : 1;
+                if (q >= end) break;  // строка не дочитана
+                p = q + 1;
+                continue;
+            }
+            if (c == '{') {
+                objStart = p;
+            } else if (c == '}' && objStart) {
+                if (!parseObject(objStart, p)) return kConsumeError;
+                objStart = nullptr;
+                safe = p + 1;
+            } else if (!objStart) {
+                safe = p + 1;
+            }
+            ++p;
+        }
+
+        if (eof && objStart) {
+            cout << "[OPC UA] Config error: " << path << ": unexpected end of file" << endl;
+            return kConsumeError;
+        }
+
+        return objStart ? objStart - data : safe - data;
+    }
+};
+
+bool endsWith(const string& s, const char* suffix) {
+    size_t n = strlen(suffix);
+    if (s.size() < n) return false;
+    for (size_t i = 0; i < n; i++) {
+        if (tolower(static_cast<unsigned char>(s[s.size() - n + i])) != suffix[i]) return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+bool TagConfigLoader::loadCsv(const std::string& path, std::vector<TagConfig>& out) {
+    CsvParser parser{out, path};
+    return streamFile(path, parser);
+}
+
+bool TagConfigLoader::loadJson(const std::string& path, std::vector<TagConfig>& out) {
+    JsonParser parser{out, path};
+    return streamFile(path, parser);
+}
+
+bool TagConfigLoader::loadFile(const std::string& path, std::vector<TagConfig>& out) {
+    if (endsWith(path, ".json")) {
+        return loadJson(path, out);
+    }
+    return loadCsv(path, out);
+}
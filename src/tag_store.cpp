@@ -0,0 +1,269 @@
+#include "../include/tag_store.hpp"
+#include <algorithm>
+#include <thread>
+
+using namespace std;
+
+const char* qualityToString(TagQuality quality) {
+    switch (quality) {
+        case TagQuality::Good: return "GOOD";
+        case TagQuality::Uncertain: return "UNCERTAIN";
+        case TagQuality::Bad: return "BAD";
+    }
+    return "UNKNOWN";
+}
+
+// ---------------- StringTable ----------------
+
+uint32_t StringTable::find(std::string_view s) const {
+    auto it = index.find(s);
+    return it != index.end() ? it->second : npos;
+}
+
+uint32_t StringTable::intern(std::string_view s) {
+    auto it = index.find(s);
+    if (it != index.end()) {
+        return it->second;
+    }
+
+    uint32_t id = static_cast<uint32_t>(strings.size());
+    strings.emplace_back(s);
+    index.emplace(strings.back(), id);
+    return id;
+}
+
+// ---------------- TagStore ----------------
+
+TagStore::Segment::Segment() {
+    // До C++20 std::atomic по умолчанию не инициализируется
+    for (size_t k = 0; k < kSegmentSize; k++) {
+        seq[k].store(0, memory_order_relaxed);
+        values[k].store(0.0, memory_order_relaxed);
+        timestamps[k].store(0, memory_order_relaxed);
+        qualities[k].store(0, memory_order_relaxed);
+        flags[k].store(0, memory_order_relaxed);
+    }
+}
+
+TagStore::~TagStore() {
+    for (auto& segment : segments) {
+        delete segment.load(memory_order_relaxed);
+    }
+}
+
+bool TagStore::ensureSegments(size_t tagCount) {
+    size_t needed = (tagCount + kSegmentSize - 1) >> kSegmentBits;
+    if (needed > kMaxSegments) {
+        return false;
+    }
+    for (size_t s = 0; s < needed; s++) {
+        if (segments[s].load(memory_order_relaxed) == nullptr) {
+            segments[s].store(new Segment(), memory_order_release);
+        }
+    }
+    return true;
+}
+
+template <typename Key>
+size_t TagStore::find(const IndexStripe<Key>* stripes, const Key& key) {
+    const IndexStripe<Key>& stripe = stripes[hash<Key>()(key) % kIndexStripes];
+    shared_lock<shared_mutex> lock(stripe.mutex);
+    auto it = stripe.map.find(key);
+    return it != stripe.map.end() ? it->second : npos;
+}
+
+template <typename Key>
+void TagStore::insert(IndexStripe<Key>* stripes, const Key& key, uint32_t index) {
+    IndexStripe<Key>& stripe = stripes[hash<Key>()(key) % kIndexStripes];
+    unique_lock<shared_mutex> lock(stripe.mutex);
+    stripe.map.emplace(key, index);
+}
+
+void TagStore::reserve(size_t n) {
+    lock_guard<mutex> lock(add_mutex);
+    ensureSegments(n);
+    for (size_t s = 0; s < kIndexStripes; s++) {
+        unique_lock<shared_mutex> nameLock(nameStripes[s].mutex);
+        nameStripes[s].map.reserve(n / kIndexStripes + 1);
+        unique_lock<shared_mutex> nodeIdLock(nodeIdStripes[s].mutex);
+        nodeIdStripes[s].map.reserve(n / kIndexStripes + 1);
+    }
+}
+
+size_t TagStore::add(const TagConfig& cfg) {
+    lock_guard<mutex> lock(add_mutex);
+
+    // Добавления упорядочены add_mutex, так что между проверкой
+    // и вставкой имя занять некому
+    if (find(nameStripes, std::string_view(cfg.name)) != npos) {
+        return npos;
+    }
+
+    size_t index = count.load(memory_order_relaxed);
+    if (!ensureSegments(index + 1)) {
+        return npos;
+    }
+
+    Segment& seg = segment(index);
+    TagMeta& m = seg.meta[offset(index)];
+    m.name = strings.get(strings.intern(cfg.name));
+    m.nodeId = strings.get(strings.intern(cfg.nodeId));
+    m.node = NodeId::fromText(cfg.nodeId);
+    m.unit = strings.get(strings.intern(cfg.unit));
+    m.minValue = cfg.minVal;
+    m.maxValue = cfg.maxVal;
+    m.samplingMs = cfg.samplingMs;
+
+    seg.flags[offset(index)].store(cfg.expression.empty() ? TAG_FLAG_NONE : TAG_FLAG_CALCULATED,
+                                   memory_order_relaxed);
+
+    // Сначала публикуем тег, потом делаем его доступным для поиска
+    count.store(index + 1, memory_order_release);
+    insert(nameStripes, m.name, static_cast<uint32_t>(index));
+    insert(nodeIdStripes, m.node, static_cast<uint32_t>(index));
+    return index;
+}
+
+size_t TagStore::findByName(std::string_view name) const {
+    return find(nameStripes, name);
+}
+
+size_t TagStore::findByNodeId(const NodeId& nodeId) const {
+    return find(nodeIdStripes, nodeId);
+}
+
+TagValue TagStore::load(size_t i) const {
+    const Segment& s = segment(i);
+    size_t k = offset(i);
+    TagValue v;
+    for (;;) {
+        uint32_t before = s.seq[k].load(memory_order_acquire);
+        if (before & 1) {
+            this_thread::yield();
+            continue;
+        }
+        v.value = s.values[k].load(memory_order_relaxed);
+        v.timestampMs = s.timestamps[k].load(memory_order_relaxed);
+        v.quality = static_cast<TagQuality>(s.qualities[k].load(memory_order_relaxed));
+        v.flags = s.flags[k].load(memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+        if (s.seq[k].load(memory_order_relaxed) == before) {
+            return v;
+        }
+    }
+}
+
+uint32_t TagStore::lockTag(Segment& s, size_t k) {
+    // Захват тега: чётный счётчик -> нечётный
+    uint32_t seq = s.seq[k].load(memory_order_relaxed);
+    for (;;) {
+        if (seq & 1) {
+            this_thread::yield();
+            seq = s.seq[k].load(memory_order_relaxed);
+            continue;
+        }
+        if (s.seq[k].compare_exchange_weak(seq, seq + 1, memory_order_acquire, memory_order_relaxed)) {
+            break;
+        }
+    }
+    atomic_thread_fence(memory_order_release);
+    return seq;
+}
+
+void TagStore::unlockTag(Segment& s, size_t k, uint32_t seq) {
+    s.seq[k].store(seq, memory_order_release);
+}
+
+void TagStore::set(size_t i, double value, int64_t timestampMs, TagQuality quality, uint8_t flagBits) {
+    Segment& s = segment(i);
+    size_t k = offset(i);
+    uint32_t seq = lockTag(s, k);
+
+    s.values[k].store(value, memory_order_relaxed);
+    s.timestamps[k].store(timestampMs, memory_order_relaxed);
+    s.qualities[k].store(static_cast<uint8_t>(quality), memory_order_relaxed);
+    s.flags[k].store(flagBits, memory_order_relaxed);
+
+    unlockTag(s, k, seq + 2);
+}
+
+bool TagStore::setUnlessWritten(size_t i, double value, int64_t timestampMs, TagQuality quality,
+                                TagValue& previous) {
+    Segment& s = segment(i);
+    size_t k = offset(i);
+    uint32_t seq = lockTag(s, k);
+
+    previous.value = s.values[k].load(memory_order_relaxed);
+    previous.timestampMs = s.timestamps[k].load(memory_order_relaxed);
+    previous.quality = static_cast<TagQuality>(s.qualities[k].load(memory_order_relaxed));
+    previous.flags = s.flags[k].load(memory_order_relaxed);
+
+    if (previous.flags & TAG_FLAG_WRITTEN) {
+        // Данные не менялись: возвращаем прежний чётный счётчик
+        unlockTag(s, k, seq);
+        return false;
+    }
+
+    s.values[k].store(value, memory_order_relaxed);
+    s.timestamps[k].store(timestampMs, memory_order_relaxed);
+    s.qualities[k].store(static_cast<uint8_t>(quality), memory_order_relaxed);
+    s.flags[k].store(previous.flags & TAG_FLAG_CALCULATED, memory_order_relaxed);
+
+    unlockTag(s, k, seq + 2);
+    return true;
+}
+
+void TagStore::setFlag(size_t i, uint8_t flag, bool on) {
+    std::atomic<uint8_t>& flags = segment(i).flags[offset(i)];
+    if (on) {
+        flags.fetch_or(flag, memory_order_acq_rel);
+    } else {
+        flags.fetch_and(static_cast<uint8_t>(~flag), memory_order_acq_rel);
+    }
+}
+
+void TagStore::snapshot(std::vector<double>& outValues, std::vector<int64_t>& outTimestamps,
+                        std::vector<TagQuality>& outQualities, std::vector<uint8_t>& outFlags) const {
+    size_t n = size();
+    outValues.resize(n);
+    outTimestamps.resize(n);
+    outQualities.resize(n);
+    outFlags.resize(n);
+
+    // Сегмент за сегментом: счётчики, подряд массивы данных, снова счётчики.
+    // Тег, который писали во время копирования, перечитывается через load.
+    uint32_t before[kSegmentSize];
+    for (size_t base = 0; base < n; base += kSegmentSize) {
+        const Segment& s = segment(base);
+        size_t m = min(kSegmentSize, n - base);
+
+        for (size_t k = 0; k < m; k++) {
+            before[k] = s.seq[k].load(memory_order_acquire);
+        }
+        for (size_t k = 0; k < m; k++) {
+            outValues[base + k] = s.values[k].load(memory_order_relaxed);
+        }
+        for (size_t k = 0; k < m; k++) {
+            outTimestamps[base + k] = s.timestamps[k].load(memory_order_relaxed);
+        }
+        for (size_t k = 0; k < m; k++) {
+            outQualities[base + k] = static_cast<TagQuality>(s.qualities[k].load(memory_order_relaxed));
+        }
+        for (size_t k = 0; k < m; k++) {
+            outFlags[base + k] = s.flags[k].load(memory_order_relaxed);
+        }
+
+        atomic_thread_fence(memory_order_acquire);
+        for (size_t k = 0; k < m; k++) {
+            uint32_t after = s.seq[k].load(memory_order_relaxed);
+            if ((before[k] & 1) || after != before[k]) {
+                TagValue v = load(base + k);
+                outValues[base + k] = v.value;
+                outTimestamps[base + k] = v.timestampMs;
+                outQualities[base + k] = v.quality;
+                outFlags[base + k] = v.flags;
+            }
+        }
+    }
+}
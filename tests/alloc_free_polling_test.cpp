@@ -0,0 +1,93 @@
+// Проверка: после прогрева цикл опроса и записи оператора
+// не обращаются к куче (readAllTags с буфером вызывающего).
+#include "../include/opcua_client.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+std::atomic<long> allocations{0};
+
+const size_t kTagCount = 1000;
+const int kWarmupCycles = 100;
+const int kMeasuredCycles = 1000;
+const int kWritesEvery = 10;    // запись оператора каждые N циклов
+
+}  // namespace
+
+// Глобальные operator new/delete считают выделения во всей программе
+void* operator new(size_t size) {
+    allocations.fetch_add(1, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+int main() {
+    OPCUAClient client;
+
+    // Интервал опроса 0: каждый цикл обновляет все теги
+    vector<TagConfig> configs;
+    for (size_t i = 0; i < kTagCount; i++) {
+        TagConfig cfg;
+        cfg.name = "T" + to_string(i);
+        cfg.nodeId = "ns=3;i=" + to_string(i);
+        cfg.samplingMs = 0;
+        configs.push_back(cfg);
+    }
+    TagConfig calc;
+    calc.name = "Sum";
+    calc.nodeId = "ns=3;s=Sum";
+    calc.samplingMs = 0;
+    calc.expression = "T1 + T2 * 2";
+    configs.push_back(calc);
+    client.addTags(configs);
+
+    vector<string> writeTargets;
+    for (int w = 0; w < kMeasuredCycles / kWritesEvery; w++) {
+        writeTargets.push_back("T" + to_string(w % kTagCount));
+    }
+
+    vector<OPCUAClient::TagData> tags;
+    auto cycle = [&](int i) {
+        client.readAllTags(tags);
+        if (i % kWritesEvery == 0) {
+            client.writeTagByName(writeTargets[(i / kWritesEvery) % writeTargets.size()], 1.0 * i);
+        }
+    };
+
+    for (int i = 0; i < kWarmupCycles; i++) {
+        cycle(i);
+    }
+
+    long before = allocations.load();
+    for (int i = 0; i < kMeasuredCycles; i++) {
+        cycle(i);
+    }
+    long allocated = allocations.load() - before;
+
+    cout << "[TEST] " << allocated << " allocations in " << kMeasuredCycles << " cycles, "
+         << kMeasuredCycles / kWritesEvery << " writes, " << tags.size() << " tags" << endl;
+    if (allocated != 0) {
+        cout << "[TEST] FAILED: steady-state polling allocates" << endl;
+        return 1;
+    }
+    cout << "[TEST] OK" << endl;
+    return 0;
+}